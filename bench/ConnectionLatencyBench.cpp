@@ -0,0 +1,229 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+
+// Round trip latency of the command channel socket options, over loopback.
+//
+// Each round trip writes two small packets back to back, a motor set-point and a watchdog as
+// Core does, then waits for the server to answer once both are in. Without TCP_NODELAY the
+// second packet waits for the ack of the first one, which the server delays.
+//
+// usage : ConnectionLatencyBench [ roundTrips ]
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "ConnectionOptions.hpp"
+
+using namespace std::chrono;
+
+namespace {
+    // encoded sizes of an HaMotorsPacket and an ApiWatchdogPacket
+    const size_t MOTORS_PACKET_SIZE = 17;
+    const size_t WATCHDOG_PACKET_SIZE = 19;
+    const size_t REQUEST_SIZE = MOTORS_PACKET_SIZE + WATCHDOG_PACKET_SIZE;
+
+    const int WARM_UP_ROUND_TRIPS = 10;
+    const int DEFAULT_ROUND_TRIPS = 200;
+    const int CONNECT_TIMEOUT_MS = 1000;
+
+    bool readFully(int socketDesc, uint8_t *data, size_t size) {
+        while (size > 0) {
+            ssize_t readSize = read(socketDesc, data, size);
+
+            if (readSize <= 0) {
+                return false;
+            }
+
+            data += readSize;
+            size -= static_cast<size_t>( readSize );
+        }
+
+        return true;
+    }
+
+    // the robot side, default options : answers each request in one write
+    void serveRequests(int listenDesc) {
+        int socketDesc = accept(listenDesc, nullptr, nullptr);
+
+        if (socketDesc < 0) {
+            return;
+        }
+
+        uint8_t request[REQUEST_SIZE];
+
+        while (readFully(socketDesc, request, REQUEST_SIZE)) {
+            if (write(socketDesc, request, REQUEST_SIZE) != static_cast<ssize_t>( REQUEST_SIZE )) {
+                break;
+            }
+        }
+
+        close(socketDesc);
+    }
+
+    int listenLoopback(uint16_t &port) {
+        int listenDesc = socket(AF_INET, SOCK_STREAM, 0);
+
+        struct sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+
+        socklen_t addressSize = sizeof(address);
+
+        if (listenDesc < 0 or
+            bind(listenDesc, reinterpret_cast<struct sockaddr *>( &address ), sizeof(address)) < 0 or
+            listen(listenDesc, 1) < 0 or
+            getsockname(listenDesc, reinterpret_cast<struct sockaddr *>( &address ), &addressSize) < 0) {
+            if (listenDesc >= 0) {
+                close(listenDesc);
+            }
+
+            return -1;
+        }
+
+        port = ntohs(address.sin_port);
+
+        return listenDesc;
+    }
+
+    // blocking socket connected with options, -1 on failure
+    int connectLoopback(uint16_t port, const ConnectionOptions &options) {
+        int socketDesc = startConnect("127.0.0.1", port, options);
+
+        if (socketDesc < 0) {
+            return -1;
+        }
+
+        struct pollfd pollDesc{};
+        pollDesc.fd = socketDesc;
+        pollDesc.events = POLLOUT;
+
+        if (poll(&pollDesc, 1, CONNECT_TIMEOUT_MS) != 1 or not finishConnect(socketDesc)) {
+            close(socketDesc);
+
+            return -1;
+        }
+
+        fcntl(socketDesc, F_SETFL, fcntl(socketDesc, F_GETFL) & ~O_NONBLOCK);
+
+        return socketDesc;
+    }
+
+    // round trip times in microseconds, empty on failure
+    std::vector<int64_t> measureRoundTrips(const ConnectionOptions &options, int roundTrips) {
+        std::vector<int64_t> roundTripsUs;
+
+        uint16_t port = 0;
+        int listenDesc = listenLoopback(port);
+
+        if (listenDesc < 0) {
+            return roundTripsUs;
+        }
+
+        std::thread server(serveRequests, listenDesc);
+
+        int socketDesc = connectLoopback(port, options);
+
+        if (socketDesc >= 0) {
+            uint8_t request[REQUEST_SIZE] = {};
+            uint8_t answer[REQUEST_SIZE];
+
+            roundTripsUs.reserve(static_cast<size_t>( roundTrips ));
+
+            for (int i = -WARM_UP_ROUND_TRIPS; i < roundTrips; i++) {
+                steady_clock::time_point start = steady_clock::now();
+
+                if (write(socketDesc, request, MOTORS_PACKET_SIZE) != static_cast<ssize_t>( MOTORS_PACKET_SIZE ) or
+                    write(socketDesc, request + MOTORS_PACKET_SIZE, WATCHDOG_PACKET_SIZE) !=
+                    static_cast<ssize_t>( WATCHDOG_PACKET_SIZE ) or
+                    not readFully(socketDesc, answer, REQUEST_SIZE)) {
+                    roundTripsUs.clear();
+
+                    break;
+                }
+
+                rearmQuickAck(socketDesc, options);
+
+                if (i >= 0) {
+                    roundTripsUs.push_back(duration_cast<microseconds>(steady_clock::now() - start).count());
+                }
+            }
+
+            close(socketDesc);
+        } else {
+            // lets the server out of accept
+            shutdown(listenDesc, SHUT_RDWR);
+        }
+
+        server.join();
+
+        close(listenDesc);
+
+        return roundTripsUs;
+    }
+
+    void printRoundTrips(const char *name, std::vector<int64_t> roundTripsUs) {
+        if (roundTripsUs.empty()) {
+            std::printf("%-12s failed\n", name);
+
+            return;
+        }
+
+        std::sort(roundTripsUs.begin(), roundTripsUs.end());
+
+        size_t count = roundTripsUs.size();
+
+        std::printf("%-12s %10lld %10lld %10lld\n", name,
+                    static_cast<long long>( roundTripsUs[count / 2] ),
+                    static_cast<long long>( roundTripsUs[count * 99 / 100] ),
+                    static_cast<long long>( roundTripsUs[count - 1] ));
+    }
+}
+
+// #################################################
+//
+int
+main(int argc, char **argv) {
+    int roundTrips = (argc > 1) ? std::atoi(argv[1]) : DEFAULT_ROUND_TRIPS;
+
+    if (roundTrips <= 0) {
+        std::fprintf(stderr, "usage : %s [ roundTrips ]\n", argv[0]);
+
+        return 1;
+    }
+
+    ConnectionOptions defaultOptions{};
+
+    std::printf("%d round trips over loopback, microseconds\n", roundTrips);
+    std::printf("%-12s %10s %10s %10s\n", "options", "p50", "p99", "max");
+
+    printRoundTrips("default", measureRoundTrips(defaultOptions, roundTrips));
+    printRoundTrips("lowLatency", measureRoundTrips(ConnectionOptions::lowLatency(), roundTrips));
+
+    return 0;
+}
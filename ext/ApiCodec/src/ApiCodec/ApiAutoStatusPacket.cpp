@@ -29,7 +29,7 @@ cl_copy::BufferUPtr ApiAutoStatusPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( autoStatusType );
 
@@ -34,29 +34,10 @@ ApiCameraExtrinsicsPacket::~ApiCameraExtrinsicsPacket( )
 //
 cl_copy::BufferUPtr ApiCameraExtrinsicsPacket::encode()
 {
-	uint cpt = 0;
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( ( 9 * 8 ) + ( 3 * 8 ) );
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( ( 9 * 8 ) + ( 3 * 8 ) );
-
-	for( uint matIdx = 0 ; matIdx < 9 ; matIdx++ )
-	{
-		cl::u8Array< 8 > encodedMat = cl::double_to_u8Array( mat[ matIdx ] );
-
-		for( uint byteIdx = 0; byteIdx < 8 ; byteIdx++ )
-		{
-			(*buffer)[cpt++] = static_cast<uint8_t>( encodedMat[ byteIdx ] );
-		}
-	}
-
-	for( uint vecIdx = 0 ; vecIdx < 3 ; vecIdx++ )
-	{
-		cl::u8Array< 8 > encodedVec = cl::double_to_u8Array( vec[ vecIdx ] );
-
-		for( uint byteIdx = 0; byteIdx < 8 ; byteIdx++ )
-		{
-			(*buffer)[cpt++] = static_cast<uint8_t>( encodedVec[ byteIdx ] );
-		}
-	}
+	cl::store_f64_n( mat, buffer->data(), 9 );
+	cl::store_f64_n( vec, buffer->data() + ( 9 * 8 ), 3 );
 
 	return std::move( getPreparedBuffer( std::move( buffer ), getPacketId() ) );
 }
@@ -69,28 +50,7 @@ void ApiCameraExtrinsicsPacket::decode( uint8_t *buffer, uint bufferSize )
 
 	uint cpt = getStartPayloadIndex();
 
-	for( uint matIdx = 0 ; matIdx < 9 ; matIdx++ )
-	{
-		cl::u8Array< 8 > encodedMat;
-
-		for( uint byteIdx = 0; byteIdx < 8 ; byteIdx++ )
-		{
-			encodedMat[ byteIdx ] =  buffer[ cpt++ ];
-		}
-
-		mat[ matIdx ] = cl::u8Array_to_double( encodedMat );
-	}
-
-	for( uint vecIdx = 0 ; vecIdx < 3 ; vecIdx++ )
-	{
-		cl::u8Array< 8 > encodedVec;
-
-		for( uint byteIdx = 0; byteIdx < 8 ; byteIdx++ )
-		{
-			encodedVec[ byteIdx ] =  buffer[ cpt++ ];
-		}
-
-		vec[ vecIdx ] = cl::u8Array_to_double( encodedVec );
-	}
+	cl::load_f64_n( buffer + cpt, mat, 9 );
+	cl::load_f64_n( buffer + cpt + ( 9 * 8 ), vec, 3 );
 }
 
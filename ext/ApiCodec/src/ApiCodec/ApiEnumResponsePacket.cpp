@@ -30,7 +30,7 @@ cl_copy::BufferUPtr ApiEnumResponsePacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 1 + 1 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 1 + 1 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( id );
 	(*buffer)[cpt++] = static_cast<uint8_t>( keyPressedType );
@@ -47,13 +47,13 @@ cl_copy::BufferUPtr ApiGprsPacket::encode()
 
 	if( gprsCommandeType == GprsCommandeType::LAST_COMMAND_OK or gprsCommandeType == GprsCommandeType::LAST_COMMAND_KO or gprsCommandeType == GprsCommandeType::CLOSE_CONNECTION )
 	{
-		buffer = cl_copy::unique_buffer( 1 );
+		buffer = getPayloadBuffer( 1 );
 
 		(*buffer)[cpt++] = static_cast<uint8_t>( gprsCommandeType );
 	}
 	else if( gprsCommandeType == GprsCommandeType::OPEN_CONNECTION )
 	{
-		buffer = cl_copy::unique_buffer( 1 + 2 + 255 );
+		buffer = getPayloadBuffer( 1 + 2 + 255 );
 
 		(*buffer)[cpt++] = static_cast<uint8_t>( gprsCommandeType );
 
@@ -77,7 +77,7 @@ cl_copy::BufferUPtr ApiGprsPacket::encode()
 	}
 	else if( gprsCommandeType == GprsCommandeType::SEND_DATA or gprsCommandeType == GprsCommandeType::DATA_RECEIVED )
 	{
-		buffer = cl_copy::unique_buffer( 1 + 2 + dataPtr->size() );
+		buffer = getPayloadBuffer( 1 + 2 + dataPtr->size() );
 
 		(*buffer)[cpt++] = static_cast<uint8_t>( gprsCommandeType );
 
@@ -93,7 +93,7 @@ cl_copy::BufferUPtr ApiGprsPacket::encode()
 	}
 	else
 	{
-		buffer = cl_copy::unique_buffer( 1);
+		buffer = getPayloadBuffer( 1);
 
 		(*buffer)[cpt++] = static_cast<uint8_t>( GprsCommandeType::LAST_COMMAND_KO );
 	}
@@ -44,7 +44,7 @@ cl_copy::BufferUPtr ApiIhmAskEnumPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 20 + 20 + 1 + (20*20) + 1 + 20 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 20 + 20 + 1 + (20*20) + 1 + 20 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( id );
 
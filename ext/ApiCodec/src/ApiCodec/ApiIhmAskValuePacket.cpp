@@ -40,7 +40,7 @@ cl_copy::BufferUPtr ApiIhmAskValuePacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 20 + 20 + 2 + 2 + 2 + 2 + 20 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 20 + 20 + 2 + 2 + 2 + 2 + 20 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( id );
 
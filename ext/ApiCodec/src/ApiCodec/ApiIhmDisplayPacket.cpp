@@ -36,7 +36,7 @@ cl_copy::BufferUPtr ApiIhmDisplayPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 20 + 20 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 20 + 20 );
 
 	for( uint i = 0 ; i < 20 ; i++ )
 	{
@@ -29,17 +29,9 @@ ApiLidarPacket::~ApiLidarPacket( )
 //
 cl_copy::BufferUPtr ApiLidarPacket::encode()
 {
-	uint cpt = 0;
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 271 * 2 );
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 271 * 2 );
-
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		cl::u8Array< 2 > encodedDistance = cl::u16_to_u8Array( distance[i] );
-
-		(*buffer)[cpt++] = static_cast<uint8_t>( encodedDistance[ 0 ] );
-		(*buffer)[cpt++] = static_cast<uint8_t>( encodedDistance[ 1 ] );
-	}
+	cl::store_be_u16_n( distance, buffer->data(), 271 );
 
 	return std::move( getPreparedBuffer( std::move( buffer ), getPacketId() ) );
 }
@@ -50,15 +42,5 @@ void ApiLidarPacket::decode( uint8_t *buffer, uint bufferSize )
 {
 	util_copy::ignore( bufferSize );
 
-	uint cpt = getStartPayloadIndex();
-
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		cl::u8Array<2> encodedDistance;
-
-		encodedDistance[0] = buffer[cpt++];
-		encodedDistance[1] = buffer[cpt++];
-
-		distance[i] = cl::u8Array_to_u16( encodedDistance );
-	}
+	cl::load_be_u16_n( buffer + getStartPayloadIndex(), distance, 271 );
 }
@@ -29,7 +29,7 @@ cl_copy::BufferUPtr ApiLogToRobotPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 127 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 127 );
 
 	for( uint i = 0; i < 127 ; i++ )
 	{
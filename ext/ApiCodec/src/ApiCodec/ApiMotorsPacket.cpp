@@ -30,7 +30,7 @@ cl_copy::BufferUPtr ApiMotorsPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 2 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 2 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( left );
 	(*buffer)[cpt++] = static_cast<uint8_t>( right );
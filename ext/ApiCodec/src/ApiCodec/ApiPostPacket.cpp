@@ -20,7 +20,7 @@ ApiPostPacket::~ApiPostPacket( )
 //
 cl_copy::BufferUPtr ApiPostPacket::encode()
 {
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + (postList.size() * (1 + 1 + 4 + 4)) );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + (postList.size() * (1 + 1 + 4 + 4)) );
 
 	uint cpt = 0;
 
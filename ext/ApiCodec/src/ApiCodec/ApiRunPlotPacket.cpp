@@ -75,7 +75,7 @@ cl_copy::BufferUPtr ApiRunPlotPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 2 + ( ( 4 + 4 + 2 ) * rowCount ) + 1 + 1 + 4 + 2 + 2 + 4 + 1 + 1 + 1 + 1 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( static_cast<size_t>( 2 + ( ( 4 + 4 + 2 ) * rowCount ) + 1 + 1 + 4 + 2 + 2 + 4 + 1 + 1 + 1 + 1 ) );
 
 	cl::u8Array< 2 > encodedRowCount = cl::u16_to_u8Array( rowCount );
 	(*buffer)[cpt++] = static_cast<uint8_t>( encodedRowCount[ 0 ] );
@@ -31,7 +31,7 @@ cl_copy::BufferUPtr ApiSmsPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 20 + 200 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 20 + 200 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( smsType );
 
@@ -42,7 +42,7 @@ cl_copy::BufferUPtr ApiStatusPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 8 + 16 + 16 + 8 + 1 + 1 + 2 + 2 + 2 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 8 + 16 + 16 + 8 + 1 + 1 + 2 + 2 + 2 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( imuReseted );
 
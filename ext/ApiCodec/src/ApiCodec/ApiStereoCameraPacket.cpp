@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 #include "ApiStereoCameraPacket.hpp"
 #include "vitals/CLByteConversion.h"
 
@@ -9,6 +10,14 @@ ApiStereoCameraPacket::ApiStereoCameraPacket( )
 
 }
 
+//=============================================================================
+//
+ApiStereoCameraPacket::ApiStereoCameraPacket( DataBufferProvider dataBufferProvider_ )
+	: 	dataBufferProvider{ std::move( dataBufferProvider_ ) }
+{
+
+}
+
 //=============================================================================
 //
 ApiStereoCameraPacket::ApiStereoCameraPacket( ImageType imageType_, cl_copy::BufferUPtr dataBuffer_ )
@@ -30,7 +39,7 @@ cl_copy::BufferUPtr ApiStereoCameraPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + 4 + dataBuffer->size() );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + 4 + dataBuffer->size() );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( imageType );
 
@@ -41,10 +50,7 @@ cl_copy::BufferUPtr ApiStereoCameraPacket::encode()
 	(*buffer)[cpt++] = static_cast<uint8_t>( encodedSize[2] );
 	(*buffer)[cpt++] = static_cast<uint8_t>( encodedSize[3] );
 
-	for ( uint i = 0; i < dataBuffer->size(); i++ )
-	{
-		(*buffer)[cpt++] = static_cast<uint8_t>( dataBuffer->at(i) );
-	}
+	std::memcpy( buffer->data() + cpt, dataBuffer->data(), dataBuffer->size() );
 
 	return std::move( getPreparedBuffer( std::move( buffer ), getPacketId() ) );
 }
@@ -53,8 +59,6 @@ cl_copy::BufferUPtr ApiStereoCameraPacket::encode()
 //
 void ApiStereoCameraPacket::decode( uint8_t *buffer, uint bufferSize )
 {
-	util_copy::ignore( bufferSize );
-
 	uint cpt = getStartPayloadIndex();
 
 	imageType = static_cast<ImageType >( buffer[ cpt++ ] );
@@ -68,12 +72,28 @@ void ApiStereoCameraPacket::decode( uint8_t *buffer, uint bufferSize )
 
 	uint32_t dataSize = cl::u8Array_to_u32( encodedSize );
 
+	// never read past the payload, whatever size is announced : the checksum follows it
+	uint payloadEnd = ( bufferSize > getChecksumSize() ) ? bufferSize - getChecksumSize() : 0;
+	uint available = ( payloadEnd > cpt ) ? payloadEnd - cpt : 0;
+
+	if( dataSize > available )
+	{
+		dataSize = available;
+	}
+
 	//std::cout << "ApiStereoCameraPacket encodedSize " << static_cast<int>(dataSize) << std::endl;
 
-	dataBuffer = cl_copy::unique_buffer( dataSize );
+	dataBuffer = nullptr;
 
-	for( uint i = 0 ; i < dataSize ; i++ )
+	if( dataBufferProvider )
 	{
-		(*dataBuffer)[i] = buffer[ cpt++ ];
+		dataBuffer = dataBufferProvider( dataSize );
 	}
+
+	if( dataBuffer == nullptr or dataBuffer->size() != dataSize )
+	{
+		dataBuffer = cl_copy::unique_buffer( dataSize );
+	}
+
+	std::memcpy( dataBuffer->data(), buffer + cpt, dataSize );
 }
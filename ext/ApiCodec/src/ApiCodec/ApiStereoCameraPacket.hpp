@@ -1,6 +1,7 @@
 #ifndef OZCORE_APISTEREOCAMERAPACKET_HPP
 #define OZCORE_APISTEREOCAMERAPACKET_HPP
 
+#include <functional>
 #include "BaseNaio01Packet.hpp"
 #include "Naio01Codec.hpp"
 
@@ -19,7 +20,12 @@ public:
 		RECTIFIED_COLORIZED_IMAGES_ZLIB = 0x06, // 376 * 240 * 3 (RGB)
 	};
 
+	// Gives the buffer the image data of dataSize bytes is decoded into, typically a view on a
+	// preallocated frame. Returning nullptr falls back to a freshly allocated buffer.
+	typedef std::function< cl_copy::BufferUPtr( size_t dataSize ) > DataBufferProvider;
+
 	ApiStereoCameraPacket( );
+	ApiStereoCameraPacket( DataBufferProvider dataBufferProvider_ );
 	ApiStereoCameraPacket( ImageType imageType_, cl_copy::BufferUPtr dataBuffer_ );
 	~ApiStereoCameraPacket( );
 
@@ -35,6 +41,7 @@ public:
 public:
 	ImageType imageType;
 	cl_copy::BufferUPtr dataBuffer;
+	DataBufferProvider dataBufferProvider;
 };
 
 typedef std::shared_ptr<ApiStereoCameraPacket> ApiStereoCameraPacketPtr;
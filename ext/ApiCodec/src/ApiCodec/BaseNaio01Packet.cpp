@@ -1,6 +1,7 @@
 #include "BaseNaio01Packet.hpp"
 #include "vitals/CLArray.h"
 #include "vitals/CLByteConversion.h"
+#include "Crc32c.hpp"
 
 //=============================================================================
 //
@@ -16,6 +17,13 @@ BaseNaio01Packet::~BaseNaio01Packet()
 
 }
 
+//=============================================================================
+//
+void BaseNaio01Packet::encodeTo( IoVecSink &sink )
+{
+	sink.append( encode() );
+}
+
 //=============================================================================
 //
 uint BaseNaio01Packet::getStartPayloadIndex()
@@ -23,36 +31,74 @@ uint BaseNaio01Packet::getStartPayloadIndex()
 	return startPayloadIndex;
 }
 
+//=============================================================================
+//
+uint BaseNaio01Packet::getChecksumSize()
+{
+	return checksumSize;
+}
+
+//=============================================================================
+//
+cl_copy::BufferUPtr BaseNaio01Packet::getPayloadBuffer( size_t payloadSize )
+{
+	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer();
+
+	buffer->reserve( startPayloadIndex + payloadSize + checksumSize );
+	buffer->resize( payloadSize, true );
+
+	return buffer;
+}
+
 //=============================================================================
 //
 cl_copy::BufferUPtr BaseNaio01Packet::getPreparedBuffer( cl_copy::BufferUPtr buffer, const uint8_t packetId )
 {
-	int packetSize = 6 + 1 + 4;
-	cl_copy::BufferUPtr preparedBuffer = cl_copy::unique_buffer( packetSize );
+	uint8_t header[ 11 ];
 
 	// HEADER
-	(*preparedBuffer)[0] = 0x4e;
-	(*preparedBuffer)[1] = 0x41;
-	(*preparedBuffer)[2] = 0x49;
-	(*preparedBuffer)[3] = 0x4f;
-	(*preparedBuffer)[4] = 0x30;
-	(*preparedBuffer)[5] = 0x31;
+	header[0] = 0x4e;
+	header[1] = 0x41;
+	header[2] = 0x49;
+	header[3] = 0x4f;
+	header[4] = 0x30;
+	header[5] = 0x31;
 
-	(*preparedBuffer)[6] = packetId;
+	header[6] = packetId;
 
 	// Add the size of the message to the packet
 	cl::u8Array< 4 > byteArr = cl::u32_to_u8Array( static_cast<uint32_t>( buffer->size() ) );
-	(*preparedBuffer)[7] = byteArr.at( 0 );
-	(*preparedBuffer)[8] = byteArr.at( 1 );
-	(*preparedBuffer)[9] = byteArr.at( 2 );
-	(*preparedBuffer)[10] = byteArr.at( 3 );
+	header[7] = byteArr.at( 0 );
+	header[8] = byteArr.at( 1 );
+	header[9] = byteArr.at( 2 );
+	header[10] = byteArr.at( 3 );
+
+	// CRC over header and payload. Peers that predate it never read these bytes.
+	uint32_t crc = crc32c( buffer->data(), buffer->size(), crc32c( header, startPayloadIndex ) );
+
+	cl::u8Array< 4 > checksum = cl::u32_to_u8Array( crc );
+
+	size_t packetSize = startPayloadIndex + buffer->size() + checksumSize;
+
+	if( not buffer->is_owner() )
+	{
+		// a view can't grow, frame a copy of the payload instead
+		cl_copy::BufferUPtr preparedBuffer = cl_copy::unique_buffer();
+
+		preparedBuffer->reserve( packetSize );
+		preparedBuffer->append( header, startPayloadIndex );
+		preparedBuffer->append( buffer->data(), buffer->size() );
+		preparedBuffer->append( checksum.data(), checksumSize );
+
+		return preparedBuffer;
+	}
 
-	// PAYLOAD
-	preparedBuffer->insert( std::move( buffer ), startPayloadIndex );
+	// no reallocation when the payload comes from getPayloadBuffer
+	buffer->reserve( packetSize );
 
-	// CRC
-	uint8_t checksum[4]{ 0, 0, 0, 0 };
-	preparedBuffer->append( checksum, 4 );
+	// PAYLOAD is moved behind the header in place
+	buffer->insert( header, startPayloadIndex, 0 );
+	buffer->append( checksum.data(), checksumSize );
 
-	return std::move( preparedBuffer );
+	return buffer;
 }
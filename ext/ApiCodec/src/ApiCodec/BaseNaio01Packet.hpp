@@ -2,6 +2,7 @@
 #define OZCORE_BASENAIO01PACKET_HPP
 
 #include "vitals/CLBuffer.hpp"
+#include "IoVecSink.hpp"
 
 class BaseNaio01Packet
 {
@@ -12,6 +13,9 @@ class BaseNaio01Packet
 
 	virtual cl_copy::BufferUPtr encode() = 0;
 
+	// Queues the encoded packet into sink, to be sent along with others in one system call.
+	virtual void encodeTo( IoVecSink &sink );
+
 	virtual void decode( uint8_t *buffer, uint32_t bufferSize ) = 0;
 
 	virtual uint8_t getPacketId() = 0;
@@ -22,9 +26,18 @@ class BaseNaio01Packet
 
 	uint32_t getStartPayloadIndex();
 
+	// bytes after the payload, part of the buffer given to decode()
+	uint32_t getChecksumSize();
+
+	// Zeroed payload buffer with room already reserved for the header and checksum, so that
+	// getPreparedBuffer frames it in place : encoding a packet costs a single allocation.
+	cl_copy::BufferUPtr getPayloadBuffer( size_t payloadSize );
+
 	private:
 
 	uint32_t startPayloadIndex = 11;
+
+	uint32_t checksumSize = 4;
 };
 
 typedef std::shared_ptr<BaseNaio01Packet> BaseNaio01PacketPtr;
@@ -0,0 +1,199 @@
+#include <cstring>
+#include "Crc32c.hpp"
+
+#if defined( __x86_64__ )
+#include <nmmintrin.h>
+#elif defined( __aarch64__ )
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+namespace
+{
+	// reflected form of 0x1EDC6F41
+	const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+	typedef uint32_t ( *Crc32cKernel )( uint32_t crc, const uint8_t *data, size_t size );
+
+	struct SliceBy8Table
+	{
+		uint32_t entries[ 8 ][ 256 ];
+
+		SliceBy8Table()
+		{
+			for( uint32_t i = 0; i < 256; i++ )
+			{
+				uint32_t crc = i;
+
+				for( int bit = 0; bit < 8; bit++ )
+				{
+					crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? CRC32C_POLYNOMIAL : 0 );
+				}
+
+				entries[ 0 ][ i ] = crc;
+			}
+
+			for( uint32_t i = 0; i < 256; i++ )
+			{
+				for( int slice = 1; slice < 8; slice++ )
+				{
+					uint32_t previous = entries[ slice - 1 ][ i ];
+
+					entries[ slice ][ i ] = ( previous >> 8 ) ^ entries[ 0 ][ previous & 0xff ];
+				}
+			}
+		}
+	};
+
+	//=============================================================================
+	//
+	uint32_t crc32cSliceBy8( uint32_t crc, const uint8_t *data, size_t size )
+	{
+		static const SliceBy8Table table;
+
+		const uint32_t ( &t )[ 8 ][ 256 ] = table.entries;
+
+		while( size >= 8 )
+		{
+			uint32_t low;
+			uint32_t high;
+
+			std::memcpy( &low, data, 4 );
+			std::memcpy( &high, data + 4, 4 );
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			low = __builtin_bswap32( low );
+			high = __builtin_bswap32( high );
+#endif
+			low ^= crc;
+
+			crc = t[ 7 ][ low & 0xff ] ^ t[ 6 ][ ( low >> 8 ) & 0xff ] ^ t[ 5 ][ ( low >> 16 ) & 0xff ] ^ t[ 4 ][ low >> 24 ] ^
+				  t[ 3 ][ high & 0xff ] ^ t[ 2 ][ ( high >> 8 ) & 0xff ] ^ t[ 1 ][ ( high >> 16 ) & 0xff ] ^ t[ 0 ][ high >> 24 ];
+
+			data += 8;
+			size -= 8;
+		}
+
+		while( size > 0 )
+		{
+			crc = ( crc >> 8 ) ^ t[ 0 ][ ( crc ^ *data ) & 0xff ];
+
+			data++;
+			size--;
+		}
+
+		return crc;
+	}
+
+#if defined( __x86_64__ )
+	//=============================================================================
+	//
+	__attribute__(( target( "sse4.2" ) ))
+	uint32_t crc32cSse42( uint32_t crc, const uint8_t *data, size_t size )
+	{
+		uint64_t crc64 = crc;
+
+		while( size >= 8 )
+		{
+			uint64_t word;
+
+			std::memcpy( &word, data, 8 );
+
+			crc64 = _mm_crc32_u64( crc64, word );
+
+			data += 8;
+			size -= 8;
+		}
+
+		crc = static_cast< uint32_t >( crc64 );
+
+		while( size > 0 )
+		{
+			crc = _mm_crc32_u8( crc, *data );
+
+			data++;
+			size--;
+		}
+
+		return crc;
+	}
+#elif defined( __aarch64__ )
+	//=============================================================================
+	//
+	__attribute__(( target( "arch=armv8-a+crc" ) ))
+	uint32_t crc32cArmv8( uint32_t crc, const uint8_t *data, size_t size )
+	{
+		while( size >= 8 )
+		{
+			uint64_t word;
+
+			std::memcpy( &word, data, 8 );
+
+			crc = __crc32cd( crc, word );
+
+			data += 8;
+			size -= 8;
+		}
+
+		while( size > 0 )
+		{
+			crc = __crc32cb( crc, *data );
+
+			data++;
+			size--;
+		}
+
+		return crc;
+	}
+#endif
+
+	struct Crc32cDispatch
+	{
+		Crc32cKernel kernel;
+		const char *name;
+
+		Crc32cDispatch()
+			:	kernel{ crc32cSliceBy8 },
+				name{ "slice-by-8" }
+		{
+#if defined( __x86_64__ )
+			__builtin_cpu_init();
+
+			if( __builtin_cpu_supports( "sse4.2" ) )
+			{
+				kernel = crc32cSse42;
+				name = "sse4.2";
+			}
+#elif defined( __aarch64__ ) && defined( HWCAP_CRC32 )
+			if( getauxval( AT_HWCAP ) & HWCAP_CRC32 )
+			{
+				kernel = crc32cArmv8;
+				name = "armv8";
+			}
+#endif
+		}
+	};
+
+	//=============================================================================
+	//
+	const Crc32cDispatch &dispatch()
+	{
+		static const Crc32cDispatch instance;
+
+		return instance;
+	}
+}
+
+//=============================================================================
+//
+uint32_t crc32c( const uint8_t *data, size_t size, uint32_t crc )
+{
+	return ~dispatch().kernel( ~crc, data, size );
+}
+
+//=============================================================================
+//
+const char *crc32cKernelName()
+{
+	return dispatch().name;
+}
@@ -0,0 +1,15 @@
+#ifndef OZCORE_CRC32C_HPP
+#define OZCORE_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C ( Castagnoli polynomial ), the one with a dedicated instruction on SSE4.2 and ARMv8.
+// The best kernel for the running cpu is picked on first use. Pass a previous result as crc to
+// checksum data spread over several buffers.
+uint32_t crc32c( const uint8_t *data, size_t size, uint32_t crc = 0 );
+
+// name of the kernel crc32c() runs with : "sse4.2", "armv8" or "slice-by-8"
+const char *crc32cKernelName();
+
+#endif //OZCORE_CRC32C_HPP
@@ -38,7 +38,7 @@ cl_copy::BufferUPtr HaCanPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 1 + dataBufferSize );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 1 + dataBufferSize );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( dataBufferSize );
 
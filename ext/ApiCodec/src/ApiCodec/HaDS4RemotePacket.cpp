@@ -45,7 +45,7 @@ cl_copy::BufferUPtr HaDS4RemotePacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 16 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 16 );
 
 	(*buffer)[cpt++] = static_cast<uint8_t>( 2 );
 
@@ -36,7 +36,7 @@ cl_copy::BufferUPtr HaGpsPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 8 + 8 + 8 + 8 + 1 + 1 + 1 + 8 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 8 + 8 + 8 + 8 + 1 + 1 + 1 + 8 );
 
 	cl::u8Array< 8 > encodedTime = cl::u64_to_u8Array( time );
 	cl::u8Array< 8 > encodedLat = cl::double_to_u8Array( lat );
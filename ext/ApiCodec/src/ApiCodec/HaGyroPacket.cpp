@@ -31,7 +31,7 @@ cl_copy::BufferUPtr HaGyroPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 2 + 2 + 2 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 2 + 2 + 2 );
 
 	cl::u8Array< 2 > encodedX = cl::i16_to_u8Array( x );
 	(*buffer)[cpt++] = static_cast<uint8_t>( encodedX[ 0 ] );
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 #include "HaLidarPacket.hpp"
 #include "vitals/CLByteConversion.h"
 
@@ -31,22 +32,11 @@ HaLidarPacket::~HaLidarPacket( )
 //
 cl_copy::BufferUPtr HaLidarPacket::encode()
 {
-	uint cpt = 0;
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( ( 271 * 2 ) + 271 );
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( ( 271 * 2 ) + 271 );
+	cl::store_be_u16_n( distance, buffer->data(), 271 );
 
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		cl::u8Array< 2 > encodedDistance = cl::u16_to_u8Array( distance[i] );
-
-		(*buffer)[cpt++] = static_cast<uint8_t>( encodedDistance[ 0 ] );
-		(*buffer)[cpt++] = static_cast<uint8_t>( encodedDistance[ 1 ] );
-	}
-
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		(*buffer)[cpt++] = static_cast<uint8_t>( albedo[ i ] );
-	}
+	std::memcpy( buffer->data() + ( 271 * 2 ), albedo, 271 );
 
 	return std::move( getPreparedBuffer( std::move( buffer ), getPacketId() ) );
 }
@@ -59,18 +49,7 @@ void HaLidarPacket::decode( uint8_t *buffer, uint bufferSize )
 
 	uint cpt = getStartPayloadIndex();
 
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		cl::u8Array<2> encodedDistance;
-
-		encodedDistance[0] = buffer[cpt++];
-		encodedDistance[1] = buffer[cpt++];
-
-		distance[i] = cl::u8Array_to_u16( encodedDistance );
-	}
+	cl::load_be_u16_n( buffer + cpt, distance, 271 );
 
-	for( uint i = 0 ; i < 271 ; i++ )
-	{
-		albedo[ i ] = buffer[cpt++];
-	}
+	std::memcpy( albedo, buffer + cpt + ( 271 * 2 ), 271 );
 }
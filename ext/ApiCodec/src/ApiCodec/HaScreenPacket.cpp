@@ -36,7 +36,7 @@ cl_copy::BufferUPtr HaScreenPacket::encode()
 {
 	uint cpt = 0;
 
-	cl_copy::BufferUPtr buffer = cl_copy::unique_buffer( 16 + 16 );
+	cl_copy::BufferUPtr buffer = getPayloadBuffer( 16 + 16 );
 
 	for( uint i = 0 ; i < 16 ; i++ )
 	{
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <sys/socket.h>
+#include "IoVecSink.hpp"
+
+//=============================================================================
+//
+IoVecSink::IoVecSink()
+	:	ioVecs_{ },
+		buffers_{ },
+		firstIoVec_{ 0 },
+		pendingSize_{ 0 }
+{
+
+}
+
+//=============================================================================
+//
+IoVecSink::~IoVecSink()
+{
+
+}
+
+//=============================================================================
+//
+void IoVecSink::append( cl_copy::BufferUPtr buffer )
+{
+	if( buffer == nullptr or buffer->size() == 0 )
+	{
+		return;
+	}
+
+	append( buffer->data(), buffer->size() );
+
+	buffers_.push_back( std::move( buffer ) );
+}
+
+//=============================================================================
+//
+void IoVecSink::append( const uint8_t *data, size_t size )
+{
+	if( size == 0 )
+	{
+		return;
+	}
+
+	iovec ioVec;
+
+	ioVec.iov_base = const_cast< uint8_t * >( data );
+	ioVec.iov_len = size;
+
+	ioVecs_.push_back( ioVec );
+
+	pendingSize_ += size;
+}
+
+//=============================================================================
+//
+size_t IoVecSink::size() const
+{
+	return pendingSize_;
+}
+
+//=============================================================================
+//
+bool IoVecSink::empty() const
+{
+	return pendingSize_ == 0;
+}
+
+//=============================================================================
+//
+bool IoVecSink::flush( int socketDesc )
+{
+	while( pendingSize_ > 0 )
+	{
+		msghdr message{ };
+
+		message.msg_iov = ioVecs_.data() + firstIoVec_;
+		message.msg_iovlen = std::min< size_t >( ioVecs_.size() - firstIoVec_, IOV_MAX );
+
+		// MSG_NOSIGNAL : a peer that went away must not kill the process with SIGPIPE
+		ssize_t sentSize = sendmsg( socketDesc, &message, MSG_NOSIGNAL );
+
+		if( sentSize < 0 )
+		{
+			if( errno == EINTR )
+			{
+				continue;
+			}
+
+			return errno == EAGAIN or errno == EWOULDBLOCK;
+		}
+
+		size_t remaining = static_cast< size_t >( sentSize );
+
+		pendingSize_ -= remaining;
+
+		while( remaining > 0 )
+		{
+			iovec &ioVec = ioVecs_[ firstIoVec_ ];
+
+			if( remaining >= ioVec.iov_len )
+			{
+				remaining -= ioVec.iov_len;
+
+				firstIoVec_++;
+			}
+			else
+			{
+				ioVec.iov_base = static_cast< uint8_t * >( ioVec.iov_base ) + remaining;
+				ioVec.iov_len -= remaining;
+
+				remaining = 0;
+			}
+		}
+	}
+
+	clear();
+
+	return true;
+}
+
+//=============================================================================
+//
+void IoVecSink::clear()
+{
+	// capacities are kept, a steady flow of batches does not allocate
+	ioVecs_.clear();
+	buffers_.clear();
+
+	firstIoVec_ = 0;
+	pendingSize_ = 0;
+}
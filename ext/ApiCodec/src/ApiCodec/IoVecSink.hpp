@@ -0,0 +1,45 @@
+#ifndef OZCORE_IOVECSINK_HPP
+#define OZCORE_IOVECSINK_HPP
+
+#include <vector>
+#include <sys/uio.h>
+#include "vitals/CLBuffer.hpp"
+
+// Gathers encoded packets as an iovec list so a whole batch goes out with a single sendmsg.
+// Nothing is copied : the sink owns the appended buffers until they are written.
+class IoVecSink
+{
+public:
+	IoVecSink();
+	~IoVecSink();
+
+	IoVecSink( const IoVecSink & ) = delete;
+	IoVecSink &operator=( const IoVecSink & ) = delete;
+
+	void append( cl_copy::BufferUPtr buffer );
+
+	// data is not owned by the sink and must stay valid until written
+	void append( const uint8_t *data, size_t size );
+
+	// bytes still to write
+	size_t size() const;
+
+	bool empty() const;
+
+	// Writes as much as the socket takes, in one sendmsg call unless the kernel accepts less or
+	// there are more than IOV_MAX pieces. Whatever is not written stays queued for the next
+	// call. Returns false on a socket error other than EAGAIN.
+	bool flush( int socketDesc );
+
+	void clear();
+
+private:
+	std::vector< iovec > ioVecs_;
+	std::vector< cl_copy::BufferUPtr > buffers_;
+
+	// ioVecs_ before this index are fully written
+	size_t firstIoVec_;
+	size_t pendingSize_;
+};
+
+#endif //OZCORE_IOVECSINK_HPP
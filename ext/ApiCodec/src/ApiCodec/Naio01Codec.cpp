@@ -1,7 +1,10 @@
 #include <vitals/CLArray.h>
 #include <vitals/CLByteConversion.h>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include "Naio01Codec.hpp"
+#include "Crc32c.hpp"
 #include "ApiPostPacket.hpp"
 #include "ApiGpsPacket.hpp"
 #include "ApiSmsPacket.hpp"
@@ -40,16 +43,42 @@
 #include "ApiCameraExtrinsicsPacket.hpp"
 #include "ApiStereoCameraPacket.hpp"
 
+namespace
+{
+	const uint8_t NAIO01_HEADER[ 6 ] = { 0x4e, 0x41, 0x49, 0x4f, 0x30, 0x31 };
+
+	const uint HEADER_MAGIC_SIZE = 6;
+
+	// NAIO01 + packet id + payload size
+	const uint HEADER_SIZE = 6 + 1 + 4;
+
+	const uint CHECKSUM_SIZE = 4;
+}
+
+// odr-used by std::array::fill and std::min
+const uint32_t Naio01Codec::DEFAULT_MAX_PAYLOAD_SIZE;
+const uint Naio01Codec::MAX_WORKING_BUFFER_SIZE;
+
 //=============================================================================
 //
 Naio01Codec::Naio01Codec() :
 		currentBasePacketList{ },
-		maxCapacity{ 1000000 },
+		packetCreators_{ },
+		packetHandlers_{ },
+		payloadStreamHandlers_{ },
+		maxPayloadSizes_{ },
+		decoderStats_{ },
+		checksumMode_{ ChecksumMode::VERIFY_IF_PRESENT },
+		activeChecksumMode_{ ChecksumMode::VERIFY_IF_PRESENT },
+		workingBuffer_{ },
+		maxCapacity{ MAX_WORKING_BUFFER_SIZE },
 		currentBufferPos{0},
 		currentMaxPacketSize{ 5000000 },
 		currentPayloadSize{ 0 }
 {
+	maxPayloadSizes_.fill( DEFAULT_MAX_PAYLOAD_SIZE );
 
+	registerDefaultPacketTypes();
 }
 
 //=============================================================================
@@ -59,11 +88,178 @@ Naio01Codec::~Naio01Codec()
 
 }
 
+//=============================================================================
+//
+void Naio01Codec::registerDefaultPacketTypes()
+{
+	registerPacketType< HaCanPacket >( Naio01CodecPacketType::HA_CAN );
+	registerPacketType< HaLidarPacket >( Naio01CodecPacketType::HA_LIDAR );
+	registerPacketType< HaAcceleroPacket >( Naio01CodecPacketType::HA_ACCELERO );
+	registerPacketType< HaActuatorPacket >( Naio01CodecPacketType::HA_ACTUATOR );
+	registerPacketType< HaGpsPacket >( Naio01CodecPacketType::HA_GPS );
+	registerPacketType< HaGyroPacket >( Naio01CodecPacketType::HA_GYRO );
+	registerPacketType< HaMagnetoPacket >( Naio01CodecPacketType::HA_MAGNETO );
+	registerPacketType< HaMotorsPacket >( Naio01CodecPacketType::HA_MOTORS );
+	registerPacketType< HaOdoPacket >( Naio01CodecPacketType::HA_ODO );
+	registerPacketType< HaDS4RemotePacket >( Naio01CodecPacketType::HA_DS4REMOTE );
+	registerPacketType< HaScreenPacket >( Naio01CodecPacketType::HA_SCREEN );
+	registerPacketType< HaSpeakerPacket >( Naio01CodecPacketType::HA_SPEAKER );
+	registerPacketType< HaKeypadPacket >( Naio01CodecPacketType::HA_KEYPAD );
+	registerPacketType< HaLedPacket >( Naio01CodecPacketType::HA_LED );
+
+	registerPacketType< ApiWatchdogPacket >( Naio01CodecPacketType::API_WATCHDOG );
+	registerPacketType< ApiAutoStatusPacket >( Naio01CodecPacketType::API_AUTO_STATUS );
+	registerPacketType< ApiPressedIhmButtonPacket >( Naio01CodecPacketType::API_PRESSED_IHM_BUTTON );
+	registerPacketType< ApiMessagePacket >( Naio01CodecPacketType::API_MESSAGE );
+	registerPacketType< ApiLogToRobotPacket >( Naio01CodecPacketType::API_LOG_TO_ROBOT );
+	registerPacketType< ApiPostPacket >( Naio01CodecPacketType::API_POST );
+	registerPacketType< ApiStereoCameraPacket >( Naio01CodecPacketType::API_RAW_STEREO_CAMERA );
+	registerPacketType< ApiGpsPacket >( Naio01CodecPacketType::API_GPS );
+	registerPacketType< ApiSmsPacket >( Naio01CodecPacketType::API_SMS );
+	registerPacketType< ApiGprsPacket >( Naio01CodecPacketType::API_GPRS );
+	registerPacketType< ApiStatusPacket >( Naio01CodecPacketType::API_STATUS );
+	registerPacketType< ApiCommandPacket >( Naio01CodecPacketType::API_COMMAND );
+	registerPacketType< ApiMotorsPacket >( Naio01CodecPacketType::API_MOTORS );
+	registerPacketType< ApiMoveActuatorPacket >( Naio01CodecPacketType::API_MOVE_ACTUATOR );
+	registerPacketType< ApiLidarPacket >( Naio01CodecPacketType::API_LIDAR );
+	registerPacketType< ApiIhmDisplayPacket >( Naio01CodecPacketType::API_IHM_DISPLAY );
+	registerPacketType< ApiIhmAskEnumPacket >( Naio01CodecPacketType::API_IHM_ASK_ENUM );
+	registerPacketType< ApiIhmAskValuePacket >( Naio01CodecPacketType::API_IHM_ASK_VALUE );
+	registerPacketType< ApiRunPlotPacket >( Naio01CodecPacketType::API_RUN_PLOT_VALUE );
+	registerPacketType< ApiEnumResponsePacket >( Naio01CodecPacketType::API_ENUM_RESPONSE );
+	registerPacketType< ApiValueResponsePacket >( Naio01CodecPacketType::API_VALUE_RESPONSE );
+	registerPacketType< ApiCameraIntrinsicsPacket >( Naio01CodecPacketType::API_CAMERA_INTRINSICS );
+	registerPacketType< ApiCameraExtrinsicsPacket >( Naio01CodecPacketType::API_CAMERA_EXTRINSICS );
+
+	// whole stereo frames are the only big packets
+	setMaxPayloadSize( static_cast<uint8_t>( Naio01CodecPacketType::API_RAW_STEREO_CAMERA ), maxCapacity );
+}
+
+//=============================================================================
+//
+void Naio01Codec::registerPacketType( uint8_t packetId, PacketCreator creator )
+{
+	packetCreators_[ packetId ] = std::move( creator );
+}
+
+//=============================================================================
+//
+void Naio01Codec::unregisterPacketType( uint8_t packetId )
+{
+	packetCreators_[ packetId ] = nullptr;
+}
+
+//=============================================================================
+//
+void Naio01Codec::setMaxPayloadSize( uint8_t packetId, uint32_t maxPayloadSize )
+{
+	maxPayloadSizes_[ packetId ] = std::min( maxPayloadSize, maxCapacity - HEADER_SIZE - CHECKSUM_SIZE );
+}
+
+//=============================================================================
+//
+uint32_t Naio01Codec::getMaxPayloadSize( uint8_t packetId ) const
+{
+	return maxPayloadSizes_[ packetId ];
+}
+
+//=============================================================================
+//
+const Naio01Codec::DecoderStats &Naio01Codec::getDecoderStats() const
+{
+	return decoderStats_;
+}
+
+//=============================================================================
+//
+void Naio01Codec::resetDecoderStats()
+{
+	decoderStats_ = DecoderStats{ };
+}
+
+//=============================================================================
+//
+void Naio01Codec::enablePacketPool( size_t maxFreePackets )
+{
+	registerPooledPacketType< HaLidarPacket >( static_cast<uint8_t>( Naio01CodecPacketType::HA_LIDAR ), maxFreePackets );
+	registerPooledPacketType< HaOdoPacket >( static_cast<uint8_t>( Naio01CodecPacketType::HA_ODO ), maxFreePackets );
+	registerPooledPacketType< HaGyroPacket >( static_cast<uint8_t>( Naio01CodecPacketType::HA_GYRO ), maxFreePackets );
+	registerPooledPacketType< HaAcceleroPacket >( static_cast<uint8_t>( Naio01CodecPacketType::HA_ACCELERO ), maxFreePackets );
+}
+
+//=============================================================================
+//
+void Naio01Codec::setPacketHandler( uint8_t packetId, PacketHandler handler )
+{
+	packetHandlers_[ packetId ] = std::move( handler );
+}
+
+//=============================================================================
+//
+void Naio01Codec::removePacketHandler( uint8_t packetId )
+{
+	packetHandlers_[ packetId ] = nullptr;
+}
+
+//=============================================================================
+//
+void Naio01Codec::setPayloadStreamHandler( uint8_t packetId, PayloadStreamHandler handler )
+{
+	payloadStreamHandlers_[ packetId ] = std::move( handler );
+}
+
+//=============================================================================
+//
+void Naio01Codec::removePayloadStreamHandler( uint8_t packetId )
+{
+	payloadStreamHandlers_[ packetId ] = nullptr;
+}
+
+//=============================================================================
+//
+void Naio01Codec::setChecksumMode( ChecksumMode mode )
+{
+	checksumMode_ = mode;
+	activeChecksumMode_ = mode;
+}
+
+//=============================================================================
+//
+Naio01Codec::ChecksumMode Naio01Codec::getChecksumMode() const
+{
+	return activeChecksumMode_;
+}
+
 //=============================================================================
 //
 void Naio01Codec::reset()
 {
 	currentBufferPos = 0;
+
+	// the next peer may be an older one
+	activeChecksumMode_ = checksumMode_;
+}
+
+//=============================================================================
+//
+size_t Naio01Codec::getWorkingBufferCapacity() const
+{
+	return workingBuffer_.size();
+}
+
+//=============================================================================
+//
+uint8_t *Naio01Codec::workingBufferOfSize( uint size )
+{
+	if( size > workingBuffer_.size() )
+	{
+		// doubling keeps a stream of growing packets from reallocating each time
+		size_t newSize = std::max( static_cast<size_t>( size ), workingBuffer_.size() * 2 );
+
+		workingBuffer_.resize( std::min( newSize, static_cast<size_t>( maxCapacity ) ) );
+	}
+
+	return workingBuffer_.data();
 }
 
 //=============================================================================
@@ -74,8 +270,6 @@ BaseNaio01PacketPtr Naio01Codec::decodeOneWholePacket( uint8_t *buffer, uint buf
 
 	if( bufferSize > 6 )
 	{
-		Naio01CodecPacketType packetType = static_cast<Naio01CodecPacketType>( buffer[ 6 ] );
-
 		if( bufferSize >= 10 )
 		{
 			cl::u8Array< 4 > payloadSizeBuffer;
@@ -91,124 +285,15 @@ BaseNaio01PacketPtr Naio01Codec::decodeOneWholePacket( uint8_t *buffer, uint buf
 //			std::cout << " packet payloadSize : " << payloadSize << std::endl;
 //			std::cout << " packet wholePacketSize : " << wholePacketSize << std::endl;
 //			std::cout << " packet bufferSize : " << bufferSize << std::endl;
-//			std::cout << " packet packetType : " << static_cast<int>( packetType ) << std::endl;
+//			std::cout << " packet packetType : " << static_cast<int>( buffer[ 6 ] ) << std::endl;
 
 			if( bufferSize == wholePacketSize )
 			{
-				switch( packetType )
+				const PacketCreator &creator = packetCreators_[ buffer[ 6 ] ];
+
+				if( creator )
 				{
-					case Naio01CodecPacketType::HA_CAN:
-						packet = std::make_shared<HaCanPacket>();
-						break;
-					case Naio01CodecPacketType::HA_LIDAR:
-						packet = std::make_shared<HaLidarPacket>();
-						break;
-					case Naio01CodecPacketType::HA_ACCELERO:
-						packet = std::make_shared<HaAcceleroPacket>();
-						break;
-					case Naio01CodecPacketType::HA_ACTUATOR:
-						packet = std::make_shared<HaActuatorPacket>();
-						break;
-					case Naio01CodecPacketType::HA_GPS:
-						packet = std::make_shared<HaGpsPacket>();
-						break;
-					case Naio01CodecPacketType::HA_GYRO:
-						packet = std::make_shared<HaGyroPacket>();
-						break;
-					case Naio01CodecPacketType::HA_MAGNETO:
-						packet = std::make_shared<HaMagnetoPacket>();
-						break;
-					case Naio01CodecPacketType::HA_MOTORS:
-						packet = std::make_shared<HaMotorsPacket>();
-						break;
-					case Naio01CodecPacketType::HA_ODO:
-						packet = std::make_shared<HaOdoPacket>();
-						break;
-					case Naio01CodecPacketType::HA_DS4REMOTE:
-						packet = std::make_shared<HaDS4RemotePacket>();
-						break;
-					case Naio01CodecPacketType::HA_SCREEN:
-						packet = std::make_shared<HaScreenPacket>();
-						break;
-					case Naio01CodecPacketType::HA_SPEAKER:
-						packet = std::make_shared<HaSpeakerPacket>();
-						break;
-					case Naio01CodecPacketType::HA_KEYPAD:
-						packet = std::make_shared<HaKeypadPacket>();
-						break;
-					case Naio01CodecPacketType::HA_LED:
-						packet = std::make_shared<HaLedPacket>();
-						break;
-
-					case Naio01CodecPacketType::API_WATCHDOG:
-						packet = std::make_shared<ApiWatchdogPacket>();
-						break;
-					case Naio01CodecPacketType::API_AUTO_STATUS:
-						packet = std::make_shared<ApiAutoStatusPacket>();
-						break;
-					case Naio01CodecPacketType::API_PRESSED_IHM_BUTTON:
-						packet = std::make_shared<ApiPressedIhmButtonPacket>();
-						break;
-					case Naio01CodecPacketType::API_MESSAGE:
-						packet = std::make_shared<ApiMessagePacket>();
-						break;
-					case Naio01CodecPacketType::API_LOG_TO_ROBOT:
-						packet = std::make_shared<ApiLogToRobotPacket>();
-						break;
-					case Naio01CodecPacketType::API_POST:
-						packet = std::make_shared<ApiPostPacket>();
-						break;
-					case Naio01CodecPacketType::API_RAW_STEREO_CAMERA:
-						packet = std::make_shared<ApiStereoCameraPacket>();
-						break;
-					case Naio01CodecPacketType::API_GPS:
-						packet = std::make_shared<ApiGpsPacket>();
-						break;
-					case Naio01CodecPacketType::API_SMS:
-						packet = std::make_shared<ApiSmsPacket>();
-						break;
-					case Naio01CodecPacketType::API_GPRS:
-						packet = std::make_shared<ApiGprsPacket>();
-						break;
-					case Naio01CodecPacketType::API_STATUS:
-						packet = std::make_shared<ApiStatusPacket>();
-						break;
-					case Naio01CodecPacketType::API_COMMAND:
-						packet = std::make_shared<ApiCommandPacket>();
-						break;
-					case Naio01CodecPacketType::API_MOTORS:
-						packet = std::make_shared<ApiMotorsPacket>();
-						break;
-					case Naio01CodecPacketType::API_MOVE_ACTUATOR:
-						packet = std::make_shared<ApiMoveActuatorPacket>();
-						break;
-					case Naio01CodecPacketType::API_LIDAR:
-						packet = std::make_shared<ApiLidarPacket>();
-						break;
-					case Naio01CodecPacketType::API_IHM_DISPLAY:
-						packet = std::make_shared<ApiIhmDisplayPacket>();
-						break;
-					case Naio01CodecPacketType::API_IHM_ASK_ENUM:
-						packet = std::make_shared<ApiIhmAskEnumPacket>();
-						break;
-					case Naio01CodecPacketType::API_IHM_ASK_VALUE:
-						packet = std::make_shared<ApiIhmAskValuePacket>();
-						break;
-					case Naio01CodecPacketType::API_RUN_PLOT_VALUE:
-						packet = std::make_shared<ApiRunPlotPacket>();
-						break;
-					case Naio01CodecPacketType::API_ENUM_RESPONSE:
-						packet = std::make_shared<ApiEnumResponsePacket>();
-						break;
-					case Naio01CodecPacketType::API_VALUE_RESPONSE:
-						packet = std::make_shared<ApiValueResponsePacket>();
-						break;
-					case Naio01CodecPacketType::API_CAMERA_INTRINSICS:
-						packet = std::make_shared<ApiCameraIntrinsicsPacket>();
-						break;
-					case Naio01CodecPacketType::API_CAMERA_EXTRINSICS:
-						packet = std::make_shared<ApiCameraExtrinsicsPacket>();
-						break;
+					packet = creator();
 				}
 
 				if( packet != nullptr )
@@ -225,59 +310,280 @@ BaseNaio01PacketPtr Naio01Codec::decodeOneWholePacket( uint8_t *buffer, uint buf
 
 //=============================================================================
 //
-bool Naio01Codec::firstPacketIdxAndSize( uint8_t *buffer, uint bufferSize, uint &firstPacketIdx, uint &firstPacketSize )
+uint Naio01Codec::findHeader( const uint8_t *buffer, uint bufferSize, uint from )
 {
-	bool atLeastOnePacketHeaderAndSizeFound = false;
-	bool headerFound = false;
+	while( from < bufferSize )
+	{
+		// memchr is vectorized by the libc, way faster than testing each byte ourselves
+		const uint8_t *candidate = static_cast<const uint8_t *>( std::memchr( buffer + from, NAIO01_HEADER[ 0 ], bufferSize - from ) );
+
+		if( candidate == nullptr )
+		{
+			return bufferSize;
+		}
+
+		uint idx = static_cast<uint>( candidate - buffer );
 
+		// a header cut by the end of the buffer still counts as a match
+		uint magicSize = std::min( bufferSize - idx, HEADER_MAGIC_SIZE );
+
+		if( std::memcmp( buffer + idx, NAIO01_HEADER, magicSize ) == 0 )
+		{
+			return idx;
+		}
+
+		from = idx + 1;
+	}
+
+	return bufferSize;
+}
+
+//=============================================================================
+//
+uint32_t Naio01Codec::readPayloadSize( const uint8_t *packetStart )
+{
+	cl::u8Array< 4 > payloadSizeBuffer;
+
+	payloadSizeBuffer[0] = packetStart[ 7 ];
+	payloadSizeBuffer[1] = packetStart[ 8 ];
+	payloadSizeBuffer[2] = packetStart[ 9 ];
+	payloadSizeBuffer[3] = packetStart[ 10 ];
+
+	return cl::u8Array_to_u32( payloadSizeBuffer );
+}
+
+//=============================================================================
+//
+bool Naio01Codec::acceptHeader( const uint8_t *packetStart, uint32_t payloadSize )
+{
+	uint8_t packetId = packetStart[ 6 ];
+
+	if( not packetCreators_[ packetId ] )
+	{
+		decoderStats_.unknownIdRejects++;
+		decoderStats_.resyncs++;
+
+		return false;
+	}
+
+	if( payloadSize > maxPayloadSizes_[ packetId ] )
+	{
+		decoderStats_.oversizeRejects++;
+		decoderStats_.resyncs++;
+
+		return false;
+	}
+
+	return true;
+}
+
+//=============================================================================
+//
+bool Naio01Codec::firstPacketIdxAndSize( uint8_t *buffer, uint bufferSize, uint &firstPacketIdx, uint &firstPacketSize )
+{
 	firstPacketIdx = 0;
 	firstPacketSize = 0;
 
-	if( bufferSize >= 11  )
+	uint idx = findHeader( buffer, bufferSize, 0 );
+
+	if( idx >= bufferSize or ( bufferSize - idx ) < HEADER_SIZE )
+	{
+		return false;
+	}
+
+	firstPacketIdx = idx;
+	firstPacketSize = readPayloadSize( buffer + idx ) + HEADER_SIZE + CHECKSUM_SIZE;
+
+	return true;
+}
+
+//=============================================================================
+//
+bool Naio01Codec::checksumMatches( const uint8_t *buffer, uint wholePacketSize )
+{
+	if( activeChecksumMode_ == ChecksumMode::IGNORE )
+	{
+		return true;
+	}
+
+	uint checksumIdx = wholePacketSize - CHECKSUM_SIZE;
+
+	cl::u8Array< 4 > checksumBuffer;
+
+	checksumBuffer[0] = buffer[ checksumIdx ];
+	checksumBuffer[1] = buffer[ checksumIdx + 1 ];
+	checksumBuffer[2] = buffer[ checksumIdx + 2 ];
+	checksumBuffer[3] = buffer[ checksumIdx + 3 ];
+
+	uint32_t receivedCrc = cl::u8Array_to_u32( checksumBuffer );
+
+	if( receivedCrc == 0 and activeChecksumMode_ == ChecksumMode::VERIFY_IF_PRESENT )
+	{
+		return true;
+	}
+
+	if( crc32c( buffer, checksumIdx ) != receivedCrc )
+	{
+		decoderStats_.checksumErrors++;
+		decoderStats_.resyncs++;
+
+		return false;
+	}
+
+	// the peer computes CRCs, from now on a zero one is a corrupted one
+	activeChecksumMode_ = ChecksumMode::REQUIRE;
+
+	return true;
+}
+
+//=============================================================================
+//
+void Naio01Codec::streamPayload( const uint8_t *packetStart, uint from, uint to )
+{
+	const PayloadStreamHandler &handler = payloadStreamHandlers_[ packetStart[ 6 ] ];
+
+	if( not handler )
+	{
+		return;
+	}
+
+	uint32_t payloadSize = readPayloadSize( packetStart );
+
+	from = std::max( from, HEADER_SIZE );
+	to = std::min( to, HEADER_SIZE + payloadSize );
+
+	if( from < to )
 	{
-		uint idx = 0;
+		handler( packetStart + from, from - HEADER_SIZE, to - from, payloadSize );
+	}
+}
+
+//=============================================================================
+//
+bool Naio01Codec::pushDecodedPacket( uint8_t *buffer, uint wholePacketSize )
+{
+	if( not checksumMatches( buffer, wholePacketSize ) )
+	{
+		return false;
+	}
+
+	BaseNaio01PacketPtr packet = decodeOneWholePacket( buffer, wholePacketSize );
+
+	if( packet == nullptr )
+	{
+		return false;
+	}
+
+	const PacketHandler &handler = packetHandlers_[ buffer[ 6 ] ];
+
+	decoderStats_.packetsDecoded++;
+
+	if( handler )
+	{
+		handler( packet );
+	}
+	else
+	{
+		currentBasePacketList.push_back( packet );
+	}
+
+	return true;
+}
+
+//=============================================================================
+//
+uint Naio01Codec::completePendingPacket( uint8_t *buffer, uint bufferSize, bool &packetHeaderDetected, bool &atLeastOnePacketDecoded )
+{
+	uint pending = static_cast<uint>( currentBufferPos );
+	uint idx = 0;
 
-		while( idx < bufferSize and headerFound == false )
+	// the header itself was cut, we need it whole to know the packet size
+	if( pending < HEADER_SIZE )
+	{
+		uint count = std::min( HEADER_SIZE - pending, bufferSize );
+		uint8_t *workingBuffer = workingBufferOfSize( HEADER_SIZE );
+
+		std::memcpy( workingBuffer + pending, buffer, count );
+
+		pending += count;
+		idx = count;
+
+		if( std::memcmp( workingBuffer, NAIO01_HEADER, std::min( pending, HEADER_MAGIC_SIZE ) ) != 0 )
 		{
-			// header can be fetch enterely
-			if( bufferSize >= ( idx + 5 ) )
-			{
-				if ((buffer[idx + 0] == 0x4e) and
-					(buffer[idx + 1] == 0x41) and
-					(buffer[idx + 2] == 0x49) and
-					(buffer[idx + 3] == 0x4f) and
-					(buffer[idx + 4] == 0x30) and
-					(buffer[idx + 5] == 0x31))
-				{
-					firstPacketIdx = idx;
-					headerFound = true;
-				}
-			}
+			// false start
+			rescanWorkingBuffer( pending, packetHeaderDetected, atLeastOnePacketDecoded );
 
-			idx++;
+			return idx;
 		}
 
-		if( headerFound == true )
+		if( pending < HEADER_SIZE )
 		{
-			if( bufferSize >= ( firstPacketIdx + 10 ) )
-			{
-				cl::u8Array< 4 > payloadSizeBuffer;
+			currentBufferPos = static_cast<int>( pending );
 
-				payloadSizeBuffer[0] = buffer[firstPacketIdx + 7];
-				payloadSizeBuffer[1] = buffer[firstPacketIdx +8];
-				payloadSizeBuffer[2] = buffer[firstPacketIdx +9];
-				payloadSizeBuffer[3] = buffer[firstPacketIdx +10];
+			return idx;
+		}
 
-				uint32_t payloadSize = cl::u8Array_to_u32( payloadSizeBuffer );
+		currentPayloadSize = readPayloadSize( workingBuffer );
 
-				firstPacketSize = payloadSize + 6 + 1 + 4 + 4;
+		if( not acceptHeader( workingBuffer, currentPayloadSize ) )
+		{
+			rescanWorkingBuffer( pending, packetHeaderDetected, atLeastOnePacketDecoded );
 
-				atLeastOnePacketHeaderAndSizeFound = true;
-			}
+			return idx;
+		}
+
+		packetHeaderDetected = true;
+	}
+
+	uint wholePacketSize = HEADER_SIZE + currentPayloadSize + CHECKSUM_SIZE;
+	uint count = std::min( wholePacketSize - pending, bufferSize - idx );
+	uint8_t *workingBuffer = workingBufferOfSize( wholePacketSize );
+
+	std::memcpy( workingBuffer + pending, buffer + idx, count );
+	streamPayload( workingBuffer, pending, pending + count );
+
+	pending += count;
+	idx += count;
+
+	if( pending == wholePacketSize )
+	{
+		currentBufferPos = 0;
+
+		if( pushDecodedPacket( workingBuffer, wholePacketSize ) )
+		{
+			atLeastOnePacketDecoded = true;
+		}
+		else
+		{
+			// the size may be what got corrupted, good packets could hide in what we buffered
+			rescanWorkingBuffer( pending, packetHeaderDetected, atLeastOnePacketDecoded );
 		}
+
+		return idx;
 	}
 
-	return atLeastOnePacketHeaderAndSizeFound;
+	currentBufferPos = static_cast<int>( pending );
+
+	return idx;
+}
+
+//=============================================================================
+//
+void Naio01Codec::rescanWorkingBuffer( uint size, bool &packetHeaderDetected, bool &atLeastOnePacketDecoded )
+{
+	bool headerDetected = false;
+
+	decoderStats_.bytesSkipped++;
+	currentBufferPos = 0;
+
+	// decode() moves a cut packet to the front with memmove, decoding the working buffer itself is
+	// safe : what it keeps is smaller than size, so the buffer is never reallocated meanwhile
+	if( decode( workingBuffer_.data() + 1, size - 1, headerDetected ) )
+	{
+		atLeastOnePacketDecoded = true;
+	}
+
+	packetHeaderDetected = packetHeaderDetected or headerDetected;
 }
 
 //=============================================================================
@@ -295,93 +601,78 @@ bool Naio01Codec::decode( uint8_t *buffer, uint bufferSize, bool &packetHeaderDe
 		currentBufferPos = 0;
 	}
 
+	// a rescan of the working buffer may leave a new cut packet behind, hence the loop
+	while( currentBufferPos > 0 and idx < bufferSize )
+	{
+		idx += completePendingPacket( buffer + idx, bufferSize - idx, packetHeaderDetected, atLeastOnePacketDecoded );
+	}
+
 	while( idx < bufferSize )
 	{
-		workingBuffer[ static_cast<uint>( currentBufferPos ) ] = buffer[ idx ];
+		uint headerIdx = findHeader( buffer, bufferSize, idx );
 
-		if( currentBufferPos == 0 and workingBuffer[0] != 0x4e )
-		{
-			currentBufferPos = -1;
-		}
-		else if( currentBufferPos == 1 and workingBuffer[1] != 0x41 )
-		{
-			currentBufferPos = -1;
-		}
-		else if( currentBufferPos == 2 and workingBuffer[2] != 0x49 )
-		{
-			currentBufferPos = -1;
-		}
-		else if( currentBufferPos == 3 and workingBuffer[3] != 0x4f )
-		{
-			currentBufferPos = -1;
-		}
-		else if( currentBufferPos == 4 and workingBuffer[4] != 0x30 )
-		{
-			currentBufferPos = -1;
-		}
-		else if( currentBufferPos == 5 and workingBuffer[5] != 0x31 )
+		decoderStats_.bytesSkipped += headerIdx - idx;
+
+		if( headerIdx >= bufferSize )
 		{
-			currentBufferPos = -1;
+			break;
 		}
-		//TEST PROTOCOL VERSION
-		else if( currentBufferPos == 5 )
+
+		uint available = bufferSize - headerIdx;
+
+		if( available < HEADER_SIZE )
 		{
-			// validate header NAIO01
-			if ((workingBuffer[0] == 0x4e) and
-				(workingBuffer[1] == 0x41) and
-				(workingBuffer[2] == 0x49) and
-				(workingBuffer[3] == 0x4f) and
-				(workingBuffer[4] == 0x30) and
-				(workingBuffer[5] == 0x31))
-			{
-				packetHeaderDetected = true;
-			}
+			// header cut by the end of this read, keep it for the next one
+			std::memmove( workingBufferOfSize( available ), buffer + headerIdx, available );
+			currentBufferPos = static_cast<int>( available );
+
+			break;
 		}
-		// REACH PROTOCOL PACKET ID
-		else if( currentBufferPos == 6 )
+
+		uint32_t payloadSize = readPayloadSize( buffer + headerIdx );
+
+		// not a real header, the next NAIO01 match is found with memchr rather than byte by byte
+		if( not acceptHeader( buffer + headerIdx, payloadSize ) )
 		{
+			decoderStats_.bytesSkipped++;
+			idx = headerIdx + 1;
 
+			continue;
 		}
-		// PACKET SIZE REACHED
-		else if( currentBufferPos == 10 )
-		{
-			cl::u8Array< 4 > payloadSizeBuffer;
 
-			payloadSizeBuffer[0] = workingBuffer[7];
-			payloadSizeBuffer[1] = workingBuffer[8];
-			payloadSizeBuffer[2] = workingBuffer[9];
-			payloadSizeBuffer[3] = workingBuffer[10];
+		packetHeaderDetected = true;
 
-			currentPayloadSize =  cl::u8Array_to_u32( payloadSizeBuffer );
-		}
-		// WHOLE PACKET RECEIVED TRY DECODING
-		else if( currentBufferPos == static_cast<int>( 6 + 1 + 4 + currentPayloadSize + 4 - 1 ) )
-		{
-//			std::cout << " packet : " << std::endl;
-//
-//			for( int xx = 0 ; xx < currentBufferPos ; xx++)
-//			{
-//				std::cout << static_cast<int>( workingBuffer[xx] ) << " ";
-//			}
-//
-//			std::cout <<  std::endl;
+		uint wholePacketSize = HEADER_SIZE + payloadSize + CHECKSUM_SIZE;
 
-			BaseNaio01PacketPtr packet = decodeOneWholePacket( workingBuffer, ( 6 + 1 + 4 + currentPayloadSize + 4 ) );
+		if( wholePacketSize <= available )
+		{
+			// whole packet lies in the caller buffer : decode it right there, no copy
+			streamPayload( buffer + headerIdx, 0, wholePacketSize );
 
-			if( packet != nullptr )
+			if( pushDecodedPacket( buffer + headerIdx, wholePacketSize ) )
 			{
-				currentBasePacketList.push_back( packet );
-
 				atLeastOnePacketDecoded = true;
-			}
 
-			currentBufferPos = -1;
+				idx = headerIdx + wholePacketSize;
+			}
+			else
+			{
+				// a corrupted size would make us skip good packets, rescan right after the magic
+				decoderStats_.bytesSkipped++;
+				idx = headerIdx + 1;
+			}
 		}
+		else
+		{
+			// only the tail fragment straddling two reads is copied
+			streamPayload( buffer + headerIdx, 0, available );
+			std::memmove( workingBufferOfSize( available ), buffer + headerIdx, available );
+			currentBufferPos = static_cast<int>( available );
+			currentPayloadSize = payloadSize;
 
-		currentBufferPos++;
-
-		idx++;
+			break;
+		}
 	}
 
 	return atLeastOnePacketDecoded;
-}
\ No newline at end of file
+}
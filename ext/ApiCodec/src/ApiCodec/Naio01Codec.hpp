@@ -1,10 +1,13 @@
 #ifndef OZCORE_NAIO01CODEC_HPP
 #define OZCORE_NAIO01CODEC_HPP
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <vector>
 #include "vitals/CLBuffer.hpp"
 #include "BaseNaio01Packet.hpp"
+#include "PacketPool.hpp"
 
 class Naio01Codec
 {
@@ -57,27 +60,197 @@ class Naio01Codec
 		API_CAMERA_EXTRINSICS = 0xB7
 	};
 
+	// How received checksums are checked. Older peers send zeros instead of a CRC, so
+	// VERIFY_IF_PRESENT only checks non-zero ones, and switches to REQUIRE once the peer has
+	// sent a valid CRC.
+	enum class ChecksumMode : uint8_t
+	{
+		IGNORE,
+		VERIFY_IF_PRESENT,
+		REQUIRE
+	};
+
+	// Decoder health counters, to be read from the decoding thread.
+	struct DecoderStats
+	{
+		uint64_t packetsDecoded;
+
+		// bytes dropped while looking for a header
+		uint64_t bytesSkipped;
+
+		// headers or packets thrown away, decoding went on from the next NAIO01 match
+		uint64_t resyncs;
+
+		uint64_t oversizeRejects;
+		uint64_t unknownIdRejects;
+		uint64_t checksumErrors;
+	};
+
+	// payload size limit of registered packet types unless setMaxPayloadSize says otherwise
+	static const uint32_t DEFAULT_MAX_PAYLOAD_SIZE = 64 * 1024;
+
+	// room for the biggest packet cut between two reads, the working buffer grows up to it only
+	// when such a packet shows up
+	static const uint MAX_WORKING_BUFFER_SIZE = 2200000;
+
+	typedef std::function< BaseNaio01PacketPtr() > PacketCreator;
+
+	typedef std::function< void( const BaseNaio01PacketPtr & ) > PacketHandler;
+
+	// Sees the payload bytes of a packet as they come in, before the packet is whole and its
+	// checksum checked. offset 0 starts a new payload, a payload that never reaches
+	// payloadSize bytes was dropped.
+	typedef std::function< void( const uint8_t *fragment, uint32_t offset, uint32_t size, uint32_t payloadSize ) > PayloadStreamHandler;
+
 	public:
 
 
 	Naio01Codec();
 	~Naio01Codec();
 
+	// Registers ( or replaces ) the factory used to build packets of a given id, so user code
+	// can decode its own packet types without touching the codec.
+	void registerPacketType( uint8_t packetId, PacketCreator creator );
+
+	template< typename PacketType >
+	void registerPacketType( uint8_t packetId )
+	{
+		registerPacketType( packetId, [] () -> BaseNaio01PacketPtr { return std::make_shared< PacketType >(); } );
+	}
+
+	template< typename PacketType >
+	void registerPacketType( Naio01CodecPacketType packetType )
+	{
+		registerPacketType< PacketType >( static_cast< uint8_t >( packetType ) );
+	}
+
+	void unregisterPacketType( uint8_t packetId );
+
+	// A header announcing a bigger payload for this id is taken for garbage, so a corrupted
+	// size field costs a rescan instead of swallowing the stream. Capped by the working buffer.
+	void setMaxPayloadSize( uint8_t packetId, uint32_t maxPayloadSize );
+
+	uint32_t getMaxPayloadSize( uint8_t packetId ) const;
+
+	// Same as registerPacketType, but packets are recycled through a PacketPool of their own.
+	template< typename PacketType >
+	void registerPooledPacketType( uint8_t packetId, size_t maxFreePackets )
+	{
+		std::shared_ptr< PacketPool< PacketType > > pool = std::make_shared< PacketPool< PacketType > >( maxFreePackets );
+
+		registerPacketType( packetId, [ pool ] () -> BaseNaio01PacketPtr { return pool->create(); } );
+	}
+
+	// Pools the high rate sensor packets ( lidar, odometry, gyro, accelero ), so that decoding
+	// steady sensor traffic does not allocate.
+	void enablePacketPool( size_t maxFreePackets = 64 );
+
+	// Handlers are called from decode() as soon as a packet of their id is decoded, picked by
+	// packet id without any RTTI. Packets without handler are queued in currentBasePacketList.
+	void setPacketHandler( uint8_t packetId, PacketHandler handler );
+
+	void removePacketHandler( uint8_t packetId );
+
+	// Lets big payloads be processed while they are still being received. The packet still
+	// goes to its handler ( or currentBasePacketList ) once whole and checked.
+	void setPayloadStreamHandler( uint8_t packetId, PayloadStreamHandler handler );
+
+	void removePayloadStreamHandler( uint8_t packetId );
+
+	template< typename PacketType >
+	void onPacket( std::function< void( const std::shared_ptr< PacketType > & ) > handler )
+	{
+		// the creator registered for this id builds a PacketType, the static cast is safe
+		setPacketHandler( packetIdOf< PacketType >(),
+			[ handler ] ( const BaseNaio01PacketPtr &packet )
+			{
+				handler( std::static_pointer_cast< PacketType >( packet ) );
+			} );
+	}
+
+	template< typename PacketType >
+	static uint8_t packetIdOf()
+	{
+		static const uint8_t packetId = PacketType().getPacketId();
+
+		return packetId;
+	}
+
+	void setChecksumMode( ChecksumMode mode );
+
+	// mode currently applied, REQUIRE once VERIFY_IF_PRESENT has seen a valid CRC
+	ChecksumMode getChecksumMode() const;
+
+	const DecoderStats &getDecoderStats() const;
+
+	void resetDecoderStats();
+
 	bool decode( uint8_t *buffer, uint bufferSize, bool &packetHeaderDetected );
 
 	BaseNaio01PacketPtr decodeOneWholePacket( uint8_t *buffer, uint bufferSize );
 
 	bool firstPacketIdxAndSize( uint8_t *buffer, uint bufferSize, uint &firstPacketIdx, uint &firstPacketSize );
 
-	uint8_t workingBuffer[2200000];
-
 	std::vector<BaseNaio01PacketPtr> currentBasePacketList;
 
+	// forgets the packet cut by the previous read, for a new connection
 	void reset();
 
+	// bytes currently allocated for cut packets
+	size_t getWorkingBufferCapacity() const;
+
 	private:
 
-	uint maxCapacity = 2200000;
+	void registerDefaultPacketTypes();
+
+	// index of the first ( possibly truncated ) NAIO01 header at or after from, bufferSize if none
+	static uint findHeader( const uint8_t *buffer, uint bufferSize, uint from );
+
+	static uint32_t readPayloadSize( const uint8_t *packetStart );
+
+	// false when the id is unknown or the payload bigger than allowed for it
+	bool acceptHeader( const uint8_t *packetStart, uint32_t payloadSize );
+
+	// feeds the packet left over by the previous call, returns the number of bytes consumed
+	uint completePendingPacket( uint8_t *buffer, uint bufferSize, bool &packetHeaderDetected, bool &atLeastOnePacketDecoded );
+
+	bool checksumMatches( const uint8_t *buffer, uint wholePacketSize );
+
+	// makes room for size bytes at the start of the working buffer
+	uint8_t *workingBufferOfSize( uint size );
+
+	// decodes again the size first buffered bytes but the first one, after a rejected packet start
+	void rescanWorkingBuffer( uint size, bool &packetHeaderDetected, bool &atLeastOnePacketDecoded );
+
+	// hands the bytes [ from, to ) of the packet starting at packetStart to its stream handler,
+	// clipped to the payload
+	void streamPayload( const uint8_t *packetStart, uint from, uint to );
+
+	// hands the packet to its handler or queues it, false if it is corrupted
+	bool pushDecodedPacket( uint8_t *buffer, uint wholePacketSize );
+
+	// indexed by packet id, empty for unknown ids
+	std::array< PacketCreator, 256 > packetCreators_;
+
+	// indexed by packet id, empty when the packet goes to currentBasePacketList
+	std::array< PacketHandler, 256 > packetHandlers_;
+
+	// indexed by packet id, empty for packets only seen whole
+	std::array< PayloadStreamHandler, 256 > payloadStreamHandlers_;
+
+	// indexed by packet id
+	std::array< uint32_t, 256 > maxPayloadSizes_;
+
+	DecoderStats decoderStats_;
+
+	// mode set by the user, restored by reset() for a new connection
+	ChecksumMode checksumMode_;
+	ChecksumMode activeChecksumMode_;
+
+	// holds the packet cut by the end of the previous read, sized to the traffic seen so far
+	std::vector< uint8_t > workingBuffer_;
+
+	uint maxCapacity = MAX_WORKING_BUFFER_SIZE;
 	int currentBufferPos = 0;
 	uint currentMaxPacketSize = 0;
 	uint currentPayloadSize = 0;
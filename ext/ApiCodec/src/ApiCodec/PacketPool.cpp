@@ -0,0 +1,65 @@
+#include "PacketPool.hpp"
+
+//=============================================================================
+//
+PacketPoolStorage::PacketPoolStorage( size_t maxFreeBlocks )
+	:	access_{ },
+		freeBlocks_{ },
+		blockSize_{ 0 },
+		maxFreeBlocks_{ maxFreeBlocks }
+{
+	freeBlocks_.reserve( maxFreeBlocks_ );
+}
+
+//=============================================================================
+//
+PacketPoolStorage::~PacketPoolStorage()
+{
+	for( void *block : freeBlocks_ )
+	{
+		::operator delete( block );
+	}
+}
+
+//=============================================================================
+//
+void *PacketPoolStorage::allocate( size_t size )
+{
+	{
+		std::lock_guard< std::mutex > lock( access_ );
+
+		if( blockSize_ == 0 )
+		{
+			blockSize_ = size;
+		}
+
+		if( size == blockSize_ and not freeBlocks_.empty() )
+		{
+			void *block = freeBlocks_.back();
+
+			freeBlocks_.pop_back();
+
+			return block;
+		}
+	}
+
+	return ::operator new( size );
+}
+
+//=============================================================================
+//
+void PacketPoolStorage::deallocate( void *block, size_t size )
+{
+	{
+		std::lock_guard< std::mutex > lock( access_ );
+
+		if( size == blockSize_ and freeBlocks_.size() < maxFreeBlocks_ )
+		{
+			freeBlocks_.push_back( block );
+
+			return;
+		}
+	}
+
+	::operator delete( block );
+}
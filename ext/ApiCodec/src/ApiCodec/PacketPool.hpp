@@ -0,0 +1,103 @@
+#ifndef OZCORE_PACKETPOOL_HPP
+#define OZCORE_PACKETPOOL_HPP
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Free list of same sized memory blocks. The block size is fixed by the first allocation, other
+// sizes fall back to the heap. Blocks may be given back from any thread.
+class PacketPoolStorage
+{
+public:
+	explicit PacketPoolStorage( size_t maxFreeBlocks );
+	~PacketPoolStorage();
+
+	PacketPoolStorage( const PacketPoolStorage & ) = delete;
+	PacketPoolStorage &operator=( const PacketPoolStorage & ) = delete;
+
+	void *allocate( size_t size );
+
+	void deallocate( void *block, size_t size );
+
+private:
+	std::mutex access_;
+	std::vector< void * > freeBlocks_;
+	size_t blockSize_;
+	size_t maxFreeBlocks_;
+};
+
+typedef std::shared_ptr< PacketPoolStorage > PacketPoolStoragePtr;
+
+// Allocator drawing from a PacketPoolStorage. Used with std::allocate_shared, the packet and its
+// shared_ptr control block live in one pooled block, recycled when the last owner drops it.
+// Each copy of the allocator keeps the storage alive until every block has come back.
+template< typename T >
+class PacketPoolAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit PacketPoolAllocator( PacketPoolStoragePtr storage )
+		: storage_{ std::move( storage ) }
+	{
+
+	}
+
+	template< typename U >
+	PacketPoolAllocator( const PacketPoolAllocator< U > &other )
+		: storage_{ other.storage_ }
+	{
+
+	}
+
+	T *allocate( size_t count )
+	{
+		return static_cast< T * >( storage_->allocate( count * sizeof( T ) ) );
+	}
+
+	void deallocate( T *block, size_t count )
+	{
+		storage_->deallocate( block, count * sizeof( T ) );
+	}
+
+	template< typename U >
+	bool operator==( const PacketPoolAllocator< U > &other ) const
+	{
+		return storage_ == other.storage_;
+	}
+
+	template< typename U >
+	bool operator!=( const PacketPoolAllocator< U > &other ) const
+	{
+		return storage_ != other.storage_;
+	}
+
+private:
+	template< typename U >
+	friend class PacketPoolAllocator;
+
+	PacketPoolStoragePtr storage_;
+};
+
+// Per packet type pool : once warm, creating a packet does not touch the heap.
+template< typename PacketType >
+class PacketPool
+{
+public:
+	explicit PacketPool( size_t maxFreePackets = 64 )
+		: storage_{ std::make_shared< PacketPoolStorage >( maxFreePackets ) }
+	{
+
+	}
+
+	std::shared_ptr< PacketType > create()
+	{
+		return std::allocate_shared< PacketType >( PacketPoolAllocator< PacketType >( storage_ ) );
+	}
+
+private:
+	PacketPoolStoragePtr storage_;
+};
+
+#endif //OZCORE_PACKETPOOL_HPP
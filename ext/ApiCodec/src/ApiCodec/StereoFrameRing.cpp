@@ -0,0 +1,76 @@
+#include "StereoFrameRing.hpp"
+
+//=============================================================================
+//
+StereoFrameRing::StereoFrameRing( size_t frameCount, size_t maxFrameSize )
+	:	frameCount_{ frameCount },
+		maxFrameSize_{ maxFrameSize },
+		exhaustedCount_{ 0 },
+		frames_{ }
+{
+
+}
+
+//=============================================================================
+//
+StereoFrameRing::~StereoFrameRing()
+{
+
+}
+
+//=============================================================================
+//
+cl_copy::BufferUPtr StereoFrameRing::acquire( size_t dataSize )
+{
+	if( dataSize == 0 or dataSize > maxFrameSize_ or frameCount_ == 0 )
+	{
+		return nullptr;
+	}
+
+	if( frames_ == nullptr )
+	{
+		frames_ = std::make_shared< Frames >();
+		frames_->memory.reset( new uint8_t[ frameCount_ * maxFrameSize_ ] );
+		frames_->free.reserve( frameCount_ );
+
+		for( size_t i = 0; i < frameCount_; i++ )
+		{
+			frames_->free.push_back( frames_->memory.get() + ( i * maxFrameSize_ ) );
+		}
+	}
+
+	frames_->access.lock();
+
+	uint8_t *frame = nullptr;
+
+	if( not frames_->free.empty() )
+	{
+		frame = frames_->free.back();
+		frames_->free.pop_back();
+	}
+
+	frames_->access.unlock();
+
+	if( frame == nullptr )
+	{
+		exhaustedCount_++;
+
+		return nullptr;
+	}
+
+	std::shared_ptr< Frames > frames = frames_;
+
+	return cl_copy::unique_buffer( frame, dataSize, [ frames ] ( uint8_t *releasedFrame )
+	{
+		frames->access.lock();
+		frames->free.push_back( releasedFrame );
+		frames->access.unlock();
+	} );
+}
+
+//=============================================================================
+//
+uint64_t StereoFrameRing::getExhaustedCount() const
+{
+	return exhaustedCount_;
+}
@@ -0,0 +1,46 @@
+#ifndef OZCORE_STEREOFRAMERING_HPP
+#define OZCORE_STEREOFRAMERING_HPP
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vitals/CLBuffer.hpp"
+
+// Preallocated frames that ApiStereoCameraPacket can decode into, so no buffer is allocated per
+// image. acquire() lends a free frame : the buffer gives it back when destroyed, from any thread,
+// so a frame is never reused while a packet still holds it. When every frame is lent, acquire()
+// returns nullptr and the packet falls back to a buffer of its own.
+class StereoFrameRing
+{
+public:
+	StereoFrameRing( size_t frameCount, size_t maxFrameSize );
+	~StereoFrameRing();
+
+	StereoFrameRing( const StereoFrameRing & ) = delete;
+	StereoFrameRing &operator=( const StereoFrameRing & ) = delete;
+
+	// Buffer of dataSize bytes on a free frame, nullptr when it does not fit in a frame or no
+	// frame is free. Meant to be called from the thread decoding the image stream.
+	cl_copy::BufferUPtr acquire( size_t dataSize );
+
+	// times acquire() found every frame lent
+	uint64_t getExhaustedCount() const;
+
+private:
+	// shared with the lent buffers, which may outlive the ring
+	struct Frames
+	{
+		std::mutex access;
+		std::vector< uint8_t * > free;
+		std::unique_ptr< uint8_t[] > memory;
+	};
+
+	size_t frameCount_;
+	size_t maxFrameSize_;
+	uint64_t exhaustedCount_;
+
+	// allocated on first use, so the ring costs nothing while video is off
+	std::shared_ptr< Frames > frames_;
+};
+
+#endif //OZCORE_STEREOFRAMERING_HPP
@@ -39,8 +39,10 @@
 cl_copy::Buffer::Buffer( const size_t sz )
 	: data_{ }
 	, size_{ sz }
+	, capacity_{ sz }
 	, owner_{ true }
 	, parentBuffer_{ }
+	, release_{ }
 {
 	if( size_ > 0 )
 	{
@@ -65,8 +67,10 @@ cl_copy::Buffer::Buffer( const size_t sz )
 cl_copy::Buffer::Buffer( uint8_t* d, const size_t sz, bool own, bool deepCopy )
 	: data_{ }
 	, size_{ sz }
+	, capacity_{ sz }
 	, owner_{ deepCopy ? true : own }
 	, parentBuffer_{ }
+	, release_{ }
 {
 	if( size_ == 0 )
 	{
@@ -99,13 +103,31 @@ cl_copy::Buffer::Buffer( uint8_t* d, const size_t sz, bool own, bool deepCopy )
 	}
 }
 
+//--------------------------------------------------------------------------------------------------
+//
+cl_copy::Buffer::Buffer( uint8_t* d, const size_t sz, ReleaseFunction release )
+	: data_{ d }
+	, size_{ sz }
+	, capacity_{ sz }
+	, owner_{ false }
+	, parentBuffer_{ }
+	, release_{ std::move( release ) }
+{
+	if( size_ == 0 )
+	{
+		throw cl::Exception( "buffer size cannot not be null", CL_ORIGIN );
+	}
+}
+
 //--------------------------------------------------------------------------------------------------
 //
 cl_copy::Buffer::Buffer( UniqueBufferPtr parentBuffer, size_t offset, size_t s )
 	: data_{ }
 	, size_{ }
+	, capacity_{ }
 	, owner_{ }
 	, parentBuffer_{ std::move( parentBuffer ) }
+	, release_{ }
 {
 	assert( parentBuffer_ );
 
@@ -147,6 +169,7 @@ cl_copy::Buffer::set_data_and_size( uint8_t* d, const size_t s )
 {
 	data_ = d;
 	size_ = s;
+	capacity_ = s;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -215,6 +238,50 @@ cl_copy::Buffer::size() const
 	return size_;
 }
 
+//--------------------------------------------------------------------------------------------------
+//
+size_t
+cl_copy::Buffer::capacity() const
+{
+	return capacity_;
+}
+
+//--------------------------------------------------------------------------------------------------
+//
+void
+cl_copy::Buffer::reserve( const size_t cap )
+{
+	if( owner_ && cap > capacity_ )
+	{
+		grow( cap );
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+//
+void
+cl_copy::Buffer::grow( const size_t minCapacity )
+{
+	size_t newCapacity = capacity_ * 2;
+
+	if( newCapacity < minCapacity )
+	{
+		newCapacity = minCapacity;
+	}
+
+	uint8_t* newPtr = new uint8_t[newCapacity];
+
+	if( size_ > 0 )
+	{
+		std::memcpy( newPtr, data_, size_ );
+	}
+
+	delete[] data_;
+
+	data_ = newPtr;
+	capacity_ = newCapacity;
+}
+
 //--------------------------------------------------------------------------------------------------
 //
 bool
@@ -245,6 +312,13 @@ cl_copy::Buffer::cleanup()
 		delete[] data_;
 		data_ = nullptr;
 	}
+	else if( release_ )
+	{
+		// back to the pool it was lent by
+		release_( data_ );
+		release_ = nullptr;
+		data_ = nullptr;
+	}
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -261,43 +335,34 @@ cl_copy::Buffer::clear()
 void
 cl_copy::Buffer::resize( const size_t sz, bool clearNewMemory )
 {
-	if( !owner_ || size_ == sz )
+	if( size_ == sz )
 	{
 		return;
 	}
 
-	// Keep a pointer to the old data and create the new buffer
-	uint8_t* oldPtr = data_;
-	uint8_t* newPtr = new uint8_t[sz];
-
-	if( sz > size_ )    // grow the buffer
+	if( !owner_ )
 	{
-		if( size_ == 0 )
+		// lent memory may be shrunk and grown back, never reallocated
+		if( release_ && sz <= capacity_ )
 		{
-			data_ = newPtr;
-		}
-		else
-		{
-			// Move the old data into the new buffer
-			data_ = reinterpret_cast<uint8_t*>( std::memcpy( newPtr, oldPtr, size_ ) );
+			size_ = sz;
 		}
 
-		if( clearNewMemory )
-		{
-			// Make sure the grown buffer data is set to zero
-			clear_chunk( data_ + size_, sz - size_ );
-		}
+		return;
 	}
-	else if( sz < size_ )    // shrink the buffer
+
+	if( sz > capacity_ )    // grow the allocation, the old data is moved along
 	{
-		// Move the old data into the new buffer
-		data_ = reinterpret_cast<uint8_t*>( std::memcpy( newPtr, oldPtr, sz ) );
+		grow( sz );
 	}
 
-	// Delete the old buffer
-	delete[] oldPtr;
+	if( sz > size_ && clearNewMemory )
+	{
+		// Make sure the grown buffer data is set to zero
+		clear_chunk( data_ + size_, sz - size_ );
+	}
 
-	// Reset the size
+	// Shrinking keeps the allocation for later growth
 	size_ = sz;
 }
 
@@ -327,6 +392,7 @@ cl_copy::Buffer::takeout( const size_t sz, const size_t offset )
 		delete[] data_;
 		data_ = newPtr;
 		size_ = newSize;
+		capacity_ = newSize;
 	}
 	else if( offset + sz == size_ ) // the chunk we are taking out is at the end of the buffer
 	{
@@ -348,6 +414,7 @@ cl_copy::Buffer::takeout( const size_t sz, const size_t offset )
 		delete[] data_;
 		data_ = newPtr;
 		size_ = newSize;
+		capacity_ = newSize;
 	}
 
 	return std::move( unique_buffer( chunkPtr, sz, true ) );
@@ -374,27 +441,10 @@ cl_copy::Buffer::insert( uint8_t* ptr, const size_t sz, const size_t pos )
 	{
 		std::memcpy( data_ + oldSize, ptr, sz );
 	}
-	else if( pos == 0 )     // insert the buffer at beginning
+	else                    // make room in place and copy the buffer in
 	{
-		std::memmove( data_ + sz, data_, oldSize );
-		std::memcpy( data_, ptr, sz );
-	}
-	else                    // insert the buffer in the middle
-	{
-		uint8_t* tmp = new uint8_t[size_];
-
-		// Move the first chunk of the old data into the new buffer
-		std::memmove( tmp, data_, pos );
-
-		// Move the buffer to insert in the middle
-		std::memmove( tmp + pos, ptr, sz );
-
-		// Move the second chunk of the old buffer into the new buffer
-		std::memmove( tmp + pos + sz, data_ + pos, oldSize - pos );
-
-		// Delete the old buffer and reset it with the new one
-		delete[] data_;
-		data_ = tmp;
+		std::memmove( data_ + pos + sz, data_ + pos, oldSize - pos );
+		std::memcpy( data_ + pos, ptr, sz );
 	}
 }
 
@@ -403,8 +453,7 @@ cl_copy::Buffer::insert( uint8_t* ptr, const size_t sz, const size_t pos )
 void
 cl_copy::Buffer::insert( BufferUPtr buffer, const size_t pos )
 {
-	Buffer* tmp = buffer.release();
-	insert( tmp->data(), tmp->size(), pos );
+	insert( buffer->data(), buffer->size(), pos );
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -422,8 +471,7 @@ cl_copy::Buffer::append( BufferUPtr buffer )
 {
 	if( !parentBuffer_ )
 	{
-		Buffer* tmp = buffer.release();
-		insert( tmp->data(), tmp->size(), size() );
+		insert( buffer->data(), buffer->size(), size() );
 	}
 }
 
@@ -448,9 +496,9 @@ cl_copy::Buffer::write( const uint8_t* d, size_t s, size_t offset )
 	size_t newSize = ((s + offset) > size_) ? s + offset : size_;
 
 	// grow the buffer if it's too small
-	if( newSize > size_ )
+	if( newSize > capacity_ )
 	{
-		resize( newSize * 2 );
+		grow( newSize );
 	}
 
 	std::memcpy( data_ + offset, d, s );
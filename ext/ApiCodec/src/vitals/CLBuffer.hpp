@@ -23,6 +23,7 @@
 
 #include "Utils.hpp"
 
+#include <functional>
 #include <memory>
 
 
@@ -52,16 +53,26 @@ class Buffer
 public:
 	typedef std::allocator< uint8_t > allocator_type;
 
+	/// Called with the data of a buffer lent by a pool when the buffer is destroyed.
+	typedef std::function< void( uint8_t* ) > ReleaseFunction;
+
 
 //--Methods-----------------------------------------------------------------------------------------
 private:
 	void clear_chunk( uint8_t* ptr, const size_t size );
 
+	/// Reallocate to at least minCapacity bytes, growing geometrically. Keeps the data.
+	void grow( const size_t minCapacity );
+
 public:
 	explicit Buffer( const size_t size = 0 );
 
 	explicit Buffer( uint8_t* data, const size_t size, bool own, bool deepCopy = false );
 
+	/// Wraps memory lent by a pool. The data is not deleted but given to release on destruction,
+	/// so the pool can lend it again. It can be shrunk, never reallocated.
+	explicit Buffer( uint8_t* data, const size_t size, ReleaseFunction release );
+
 	/// Constructs a sub-buffer of the parent buffer. No allocation is performed
 	/// nor deletion. Offset and size must fit in parent buffer size. We assume
 	/// parent buffer is deleted after this sub-buffer. Caller must manage so.
@@ -89,6 +100,13 @@ public:
 
 	size_t size() const;
 
+	/// Number of bytes allocated. Growing the buffer up to the capacity does not reallocate.
+	size_t capacity() const;
+
+	/// Make room for at least capacity bytes so that following resize, insert, append or write
+	/// calls stay in place. Only applies to owned buffers.
+	void reserve( const size_t capacity );
+
 	bool is_owner() const;
 
 	void release_ownership();
@@ -126,9 +144,12 @@ public:
 private:
 	uint8_t* data_;
 	size_t size_;
+	size_t capacity_;
 	bool owner_;
 
 	BufferConstPtr parentBuffer_;
+
+	ReleaseFunction release_;
 };
 
 using BufferSPtr = std::shared_ptr< Buffer >;
@@ -20,10 +20,27 @@
 
 #include "vitals/CLByteConversion.h"
 
+#include <cstring>
+
 
 //=============================================================================
 // C O N S T A N T S   &   L O C A L   C O D E
 
+// the bulk kernels rely on the loop vectorizer, which gcc only runs from -O3
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#define CL_VECTORIZE __attribute__(( optimize( "O3" ) ))
+#else
+#define CL_VECTORIZE
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CL_BE16( value ) __builtin_bswap16( value )
+#define CL_BE32( value ) __builtin_bswap32( value )
+#else
+#define CL_BE16( value ) ( value )
+#define CL_BE32( value ) ( value )
+#endif
+
 //=============================================================================
 // C O N S T R U C T O R (S) / D E S T R U C T O R   C O D E   S E C T I O N
 
@@ -177,3 +194,73 @@ cl::u8Array_to_double( const std::array< uint8_t, 8 >& arr )
 
 	return result;
 }
+
+// big endian ubytes to uint16 array
+CL_VECTORIZE void
+cl::load_be_u16_n( const uint8_t* __restrict__ bytes, uint16_t* __restrict__ values, size_t count )
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		uint16_t value;
+
+		std::memcpy( &value, bytes + i * sizeof( value ), sizeof( value ) );
+
+		values[i] = CL_BE16( value );
+	}
+}
+
+// uint16 array to big endian ubytes
+CL_VECTORIZE void
+cl::store_be_u16_n( const uint16_t* __restrict__ values, uint8_t* __restrict__ bytes, size_t count )
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		uint16_t value = CL_BE16( values[i] );
+
+		std::memcpy( bytes + i * sizeof( value ), &value, sizeof( value ) );
+	}
+}
+
+// big endian ubytes to uint32 array
+CL_VECTORIZE void
+cl::load_be_u32_n( const uint8_t* __restrict__ bytes, uint32_t* __restrict__ values, size_t count )
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		uint32_t value;
+
+		std::memcpy( &value, bytes + i * sizeof( value ), sizeof( value ) );
+
+		values[i] = CL_BE32( value );
+	}
+}
+
+// uint32 array to big endian ubytes
+CL_VECTORIZE void
+cl::store_be_u32_n( const uint32_t* __restrict__ values, uint8_t* __restrict__ bytes, size_t count )
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		uint32_t value = CL_BE32( values[i] );
+
+		std::memcpy( bytes + i * sizeof( value ), &value, sizeof( value ) );
+	}
+}
+
+// ubytes to double array (memory order)
+void
+cl::load_f64_n( const uint8_t* bytes, double* values, size_t count )
+{
+	static_assert( sizeof( double ) == 8, "sizeof(double) != 8" );
+
+	std::memcpy( values, bytes, count * sizeof( double ) );
+}
+
+// double array to ubytes (memory order)
+void
+cl::store_f64_n( const double* values, uint8_t* bytes, size_t count )
+{
+	static_assert( sizeof( double ) == 8, "sizeof(double) != 8" );
+
+	std::memcpy( bytes, values, count * sizeof( double ) );
+}
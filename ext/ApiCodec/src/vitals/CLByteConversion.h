@@ -120,6 +120,28 @@ cl::u8Array< 8 > double_to_u8Array( const double value );
 // uint8 to double conversions (little endian)
 double u8Array_to_double( const cl::u8Array< 8 >& arr );
 
+// Bulk conversions between byte streams and arrays, bytes need no particular alignment. Written
+// as plain loops the vectorizer turns into pshufb / rev16 code, prefer them to the per value
+// functions above for long arrays.
+
+// count big endian uint16 from bytes
+void load_be_u16_n( const uint8_t* bytes, uint16_t* values, size_t count );
+
+// count uint16 to big endian bytes
+void store_be_u16_n( const uint16_t* values, uint8_t* bytes, size_t count );
+
+// count big endian uint32 from bytes
+void load_be_u32_n( const uint8_t* bytes, uint32_t* values, size_t count );
+
+// count uint32 to big endian bytes
+void store_be_u32_n( const uint32_t* values, uint8_t* bytes, size_t count );
+
+// count doubles from bytes, in memory order like u8Array_to_double
+void load_f64_n( const uint8_t* bytes, double* values, size_t count );
+
+// count doubles to bytes, in memory order like double_to_u8Array
+void store_f64_n( const double* values, uint8_t* bytes, size_t count );
+
 /// bitset -> uint8
 template< size_t N >
 inline uint8_t bitset_to_uint8( const std::bitset< N >& bitset )
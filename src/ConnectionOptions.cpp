@@ -0,0 +1,157 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "ConnectionOptions.hpp"
+
+#include <cerrno>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    bool setIntOption(int socketDesc, int level, int name, int value) {
+        return setsockopt(socketDesc, level, name, &value, sizeof(value)) == 0;
+    }
+}
+
+// #################################################
+//
+ConnectionOptions
+ConnectionOptions::lowLatency() {
+    ConnectionOptions options{};
+
+    options.noDelay = true;
+    options.quickAck = true;
+    options.receiveBufferSize = 0;
+    options.sendBufferSize = 0;
+    options.busyPollUs = 0;
+    options.keepAlive = true;
+    options.keepAliveIdleS = 2;
+    options.keepAliveIntervalS = 1;
+    options.keepAliveCount = 3;
+    options.connectTimeoutMs = 3000;
+
+    return options;
+}
+
+// #################################################
+//
+ConnectionOptions
+ConnectionOptions::highThroughput() {
+    ConnectionOptions options{};
+
+    options.noDelay = true;
+    options.quickAck = false;
+
+    // room for two whole stereo frames in flight
+    options.receiveBufferSize = 4 * 1024 * 1024;
+    options.sendBufferSize = 0;
+    options.busyPollUs = 0;
+    options.keepAlive = true;
+    options.keepAliveIdleS = 5;
+    options.keepAliveIntervalS = 2;
+    options.keepAliveCount = 3;
+    options.connectTimeoutMs = 3000;
+
+    return options;
+}
+
+// #################################################
+//
+bool
+applyConnectionOptions(int socketDesc, const ConnectionOptions &options) {
+    bool applied = true;
+
+    applied &= setIntOption(socketDesc, IPPROTO_TCP, TCP_NODELAY, options.noDelay ? 1 : 0);
+
+    if (options.quickAck) {
+        applied &= setIntOption(socketDesc, IPPROTO_TCP, TCP_QUICKACK, 1);
+    }
+
+    if (options.receiveBufferSize > 0) {
+        applied &= setIntOption(socketDesc, SOL_SOCKET, SO_RCVBUF, options.receiveBufferSize);
+    }
+
+    if (options.sendBufferSize > 0) {
+        applied &= setIntOption(socketDesc, SOL_SOCKET, SO_SNDBUF, options.sendBufferSize);
+    }
+
+#ifdef SO_BUSY_POLL
+    if (options.busyPollUs > 0) {
+        applied &= setIntOption(socketDesc, SOL_SOCKET, SO_BUSY_POLL, options.busyPollUs);
+    }
+#endif
+
+    applied &= setIntOption(socketDesc, SOL_SOCKET, SO_KEEPALIVE, options.keepAlive ? 1 : 0);
+
+    if (options.keepAlive) {
+        applied &= setIntOption(socketDesc, IPPROTO_TCP, TCP_KEEPIDLE, options.keepAliveIdleS);
+        applied &= setIntOption(socketDesc, IPPROTO_TCP, TCP_KEEPINTVL, options.keepAliveIntervalS);
+        applied &= setIntOption(socketDesc, IPPROTO_TCP, TCP_KEEPCNT, options.keepAliveCount);
+    }
+
+    return applied;
+}
+
+// #################################################
+//
+void
+rearmQuickAck(int socketDesc, const ConnectionOptions &options) {
+    if (options.quickAck) {
+        setIntOption(socketDesc, IPPROTO_TCP, TCP_QUICKACK, 1);
+    }
+}
+
+// #################################################
+//
+int
+startConnect(const std::string &host, uint16_t port, const ConnectionOptions &options) {
+    int socketDesc = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (socketDesc < 0) {
+        return -1;
+    }
+
+    // buffer sizes must be known before the handshake
+    applyConnectionOptions(socketDesc, options);
+
+    struct sockaddr_in server{};
+
+    server.sin_addr.s_addr = inet_addr(host.c_str());
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+
+    if (connect(socketDesc, (struct sockaddr *) &server, sizeof(server)) < 0 and errno != EINPROGRESS) {
+        close(socketDesc);
+
+        return -1;
+    }
+
+    return socketDesc;
+}
+
+// #################################################
+//
+bool
+finishConnect(int socketDesc) {
+    int error = 0;
+    socklen_t errorSize = sizeof(error);
+
+    return getsockopt(socketDesc, SOL_SOCKET, SO_ERROR, &error, &errorSize) == 0 and error == 0;
+}
@@ -0,0 +1,72 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef CONNECTION_OPTIONS_HPP
+#define CONNECTION_OPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+// Socket tuning of one robot channel, applied by startConnect.
+struct ConnectionOptions
+{
+	// disables Nagle, small packets leave at once
+	bool noDelay;
+
+	// rearmed after every read, the kernel clears it on its own
+	bool quickAck;
+
+	// SO_RCVBUF / SO_SNDBUF in bytes, 0 keeps the system default. Set before connect so the
+	// window scale is negotiated accordingly ; the kernel caps them to net.core.[rw]mem_max.
+	int receiveBufferSize;
+	int sendBufferSize;
+
+	// SO_BUSY_POLL in microseconds, 0 disables. Trades cpu for latency, values above
+	// net.core.busy_read need CAP_NET_ADMIN.
+	int busyPollUs;
+
+	// detects a robot gone without closing the connection ( power cut, wifi lost )
+	bool keepAlive;
+	int keepAliveIdleS;
+	int keepAliveIntervalS;
+	int keepAliveCount;
+
+	// 0 waits as long as the system connect does
+	int64_t connectTimeoutMs;
+
+	// small packets, fast loss detection : the command channel
+	static ConnectionOptions lowLatency( );
+
+	// megabytes of stereo frames per second : the image channel
+	static ConnectionOptions highThroughput( );
+};
+
+// Applies options to a socket, connected or not. Every option is tried, false if any was refused.
+bool applyConnectionOptions( int socketDesc, const ConnectionOptions &options );
+
+// Sets TCP_QUICKACK again if the options ask for it, to call after each read.
+void rearmQuickAck( int socketDesc, const ConnectionOptions &options );
+
+// Opens a non blocking TCP socket tuned with options and starts connecting it to host:port.
+// The socket becomes writable once the outcome is known, see finishConnect. Returns -1 on
+// immediate failure.
+int startConnect( const std::string &host, uint16_t port, const ConnectionOptions &options );
+
+// Outcome of a connect begun by startConnect, once its socket is writable.
+bool finishConnect( int socketDesc );
+
+#endif // CONNECTION_OPTIONS_HPP
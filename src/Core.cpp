@@ -1,6 +1,9 @@
 #include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
 #include <sys/socket.h>
-#include <arpa/inet.h>
 #include <chrono>
 #include <unistd.h>
 #include <ApiCodec/ApiMotorsPacket.hpp>
@@ -10,6 +13,7 @@
 #include <zlib.h>
 #include <ApiWatchdogPacket.hpp>
 #include "Core.hpp"
+#include "ImageConversion.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -24,36 +28,62 @@ Core::Core() :
         graphicThread_{},
         hostAdress_{"10.0.1.1"},
         hostPort_{5555},
-        socketConnected_{false},
+        commandConnectionOptions_(ConnectionOptions::lowLatency()),
+        imageConnectionOptions_(ConnectionOptions::highThroughput()),
+        eventLoop_{},
+        commandConnection_{eventLoop_, "server"},
+        imageConnection_{eventLoop_, "image server"},
+        videoEnabled_{false},
+        networkThread_{},
+        receiveBuffer_(RECEIVE_BUFFER_SIZE),
         naioCodec_{},
-        sendPacketList_{},
-        ha_lidar_packet_ptr_{nullptr},
-        ha_odo_packet_ptr_{nullptr},
-        api_post_packet_ptr_{nullptr},
-        ha_gps_packet_ptr_{nullptr},
+        commandQueue_{COMMAND_QUEUE_CAPACITY},
+        sendSink_{},
+        commandStallStartMs_{-1},
+        commandStallTotalMs_{0},
+        motorKeepAliveTimer_{-1},
+        motorSendPending_{false},
+        ha_lidar_packet_{},
+        ha_gyro_packet_{},
+        ha_accel_packet_{},
+        ha_odo_packet_{},
+        api_post_packet_{},
+        ha_gps_packet_{},
+        obstacleDetector_{},
+        api_stereo_camera_packet_ptr_{nullptr},
+        api_stereo_camera_packet_ready_{},
+        imagePreparerStopAsked_{false},
+        stereoFrames_{},
+        displayedFrameSequence_{0},
+        leftImageTexture_{nullptr},
+        rightImageTexture_{nullptr},
+        imageTextureFormat_{SDL_PIXELFORMAT_UNKNOWN},
+        imageTextureWidth_{0},
+        uploadedFrameSequence_{0},
+        grayTexturesUnsupported_{false},
+        neutralChromaPlane_{},
+        grayExpansionBuffer_{},
         controlType_{ControlType::CONTROL_TYPE_MANUAL},
+        lidarRenderer_{271, -45.0f, 1.0f},
         last_motor_time_{0L},
         imageNaioCodec_{},
+        stereoFrameRing_{STEREO_FRAME_RING_SIZE, STEREO_FRAME_MAX_SIZE},
+        imageInflater_{STEREO_FRAME_RING_SIZE, STEREO_FRAME_MAX_SIZE},
         last_left_motor_{0},
-        last_right_motor_{0},
-        last_image_received_time_{0} {
-    uint8_t fake = 0;
-
-    for (int i = 0; i < 1000000; i++) {
-        if (fake >= 255) {
-            fake = 0;
-        }
-
-        last_images_buffer_[i] = fake;
-
-        fake++;
-    }
+        last_right_motor_{0} {
     buttons = new SDL_Rect[8];
+
+    // the robot at ( 400, 400 ), a pixel per centimeter, only the half plane in front of it
+    lidarRenderer_.setView(400, 400, 0.1f);
+    lidarRenderer_.setDrawnSector(0.0f, 180.0f);
 }
 
 // #################################################
 //
 Core::~Core() {
+    stopNetworkThread();
+    stopImagePreparerThread();
+
     delete[] buttons;
 }
 
@@ -66,13 +96,6 @@ Core::init(std::string hostAdress, uint16_t hostPort) {
 
     stopThreadAsked_ = false;
     threadStarted_ = false;
-    socketConnected_ = false;
-
-    imageServerThreadStarted_ = false;
-    stopImageServerThreadAsked_ = false;
-
-    serverReadthreadStarted_ = false;
-    stopServerWriteThreadAsked_ = false;
 
     posX = 0.0;
     posY = 0.0;
@@ -92,31 +115,11 @@ Core::init(std::string hostAdress, uint16_t hostPort) {
     mouse_pos_y = -1;
     command_interface = false;
 
-    std::cout << "Connecting to : " << hostAdress << ":" << hostPort << std::endl;
-
-    struct sockaddr_in server;
-
-    //Create socket
-#if DEBUG_INTERFACE == 1
-    socket_desc_ = socket(AF_INET, SOCK_STREAM, 0);
+    naioCodec_.enablePacketPool();
 
-    if (socket_desc_ == -1) {
-        std::cout << "Could not create socket" << std::endl;
-    }
-
-    server.sin_addr.s_addr = inet_addr(hostAdress.c_str());
-    server.sin_family = AF_INET;
-    server.sin_port = htons(hostPort);
+    registerPacketHandlers();
 
-    //Connect to remote server
-    if (connect(socket_desc_, (struct sockaddr *) &server, sizeof(server)) < 0) {
-        puts("connect error");
-    }
-    else {
-        puts("Connected\n");
-        socketConnected_ = true;
-    }
-#endif
+    std::cout << "Connecting to : " << hostAdress << ":" << hostPort << std::endl;
 
     // creates main thread
     graphicThread_ = std::thread(&Core::graphic_thread, this);
@@ -124,12 +127,9 @@ Core::init(std::string hostAdress, uint16_t hostPort) {
     info_thread = std::thread(&Core::calc_info, this);
 
 #if DEBUG_INTERFACE == 1
-    serverReadThread_ = std::thread(&Core::server_read_thread, this);
-
-    serverWriteThread_ = std::thread(&Core::server_write_thread, this);
-
-    imageServerThread_ = std::thread(&Core::image_server_thread, this);
+    image_prepared_thread_ = std::thread(&Core::image_preparer_thread, this);
 
+    networkThread_ = std::thread(&Core::network_thread, this);
 #endif
 }
 
@@ -148,46 +148,78 @@ Core::stop() {
 
 // #################################################
 //
-void Core::stopServerReadThread() {
-    if (serverReadthreadStarted_) {
-        stopServerReadThreadAsked_ = true;
+void Core::setConnectionOptions(const ConnectionOptions &commandOptions, const ConnectionOptions &imageOptions) {
+    commandConnectionOptions_ = commandOptions;
+    imageConnectionOptions_ = imageOptions;
+}
 
-        serverReadThread_.join();
+// #################################################
+//
+Core::ImageStats
+Core::getImageStats() const {
+    ImageStats stats{};
 
-        serverReadthreadStarted_ = false;
+    stats.preparedFrameSequence = stereoFrames_.publishedCount();
+    stats.displayedFrameSequence = displayedFrameSequence_;
+    stats.droppedFrames = stereoFrames_.droppedCount();
+
+    return stats;
+}
+
+// #################################################
+//
+void Core::stopNetworkThread() {
+    if (networkThread_.joinable()) {
+        eventLoop_.stop();
+
+        networkThread_.join();
     }
 }
 
 // #################################################
-// thread function
-void Core::server_read_thread() {
-    std::cout << "Starting server read thread !" << std::endl;
+// thread function : serves both servers and their timers
+void Core::network_thread() {
+    std::cout << "Starting network thread !" << std::endl;
 
-    uint8_t receiveBuffer[4000000];
+    motorKeepAliveTimer_ = eventLoop_.addTimer(0, [this]() { sendMotorSetPoint(); });
 
-    while (!stopServerReadThreadAsked_) {
-        // any time : read incoming messages.
-        int readSize = (int) read(socket_desc_, receiveBuffer, 4000000);
+    commandConnection_.setCallbacks([this](int) { onServerConnected(); }, [this](uint32_t events) {
+        if (events & EPOLLOUT) {
+            flushCommandSocket();
+        }
 
-        if (readSize > 0) {
-            bool packetHeaderDetected = false;
+        if ((events & ~static_cast<uint32_t>( EPOLLOUT )) == 0 or not commandConnection_.isConnected()) {
+            return;
+        }
 
-            bool atLeastOnePacketReceived = naioCodec_.decode(receiveBuffer, static_cast<uint>( readSize ),
-                                                              packetHeaderDetected);
+        if (not readAndDecode(commandConnection_, naioCodec_)) {
+            commandConnection_.reconnect("read error");
+        }
+    }, [this]() { onServerDisconnected(); });
 
-            // manage received messages
-            if (atLeastOnePacketReceived) {
-                for (auto &&packetPtr : naioCodec_.currentBasePacketList) {
-                    manageReceivedPacket(packetPtr);
-                }
+    // the robot streams its sensors, a silent server is a dead link
+    commandConnection_.setSilenceTimeout(SERVER_SILENCE_TIMEOUT_MS);
 
-                naioCodec_.currentBasePacketList.clear();
-            }
+    imageConnection_.setCallbacks([this](int) { imageNaioCodec_.reset(); }, [this](uint32_t) {
+        if (not readAndDecode(imageConnection_, imageNaioCodec_)) {
+            imageConnection_.reconnect("read error");
         }
-    }
+    }, nullptr);
+
+    commandConnection_.open(hostAdress_, hostPort_, commandConnectionOptions_);
+    imageConnection_.open(hostAdress_, static_cast<uint16_t>( hostPort_ + 2 ), imageConnectionOptions_);
+
+    int watchdogTimer = eventLoop_.addTimer(IMAGE_SERVER_WATCHDOG_SENDING_RATE_MS, [this]() { sendImageWatchdog(); });
+
+    eventLoop_.run();
+
+    commandConnection_.close();
+    imageConnection_.close();
+
+    eventLoop_.removeTimer(motorKeepAliveTimer_);
+    eventLoop_.removeTimer(watchdogTimer);
 
-    serverReadthreadStarted_ = false;
-    stopServerReadThreadAsked_ = false;
+    std::cout << "Stopping network thread." << std::endl;
 }
 
 // #################################################
@@ -223,23 +255,20 @@ Core::graphic_thread() {
                 ApiCommandPacketPtr api_command_packet_stereo_on = std::make_shared<ApiCommandPacket>(
                         ApiCommandPacket::CommandType::TURN_ON_API_RAW_STEREO_CAMERA_PACKET);
 
-                sendPacketListAccess_.lock();
-                sendPacketList_.emplace_back(api_command_packet_zlib_off);
-                sendPacketList_.emplace_back(api_command_packet_stereo_on);
-                sendPacketListAccess_.unlock();
+                // commands are idempotent : if the queue is full, all of them are sent again next tick
+                asked_start_video_ = not (commandQueue_.push(api_command_packet_zlib_off, SendPolicy::NEVER_DROP) and
+                                          commandQueue_.push(api_command_packet_stereo_on, SendPolicy::NEVER_DROP));
 
-                asked_start_video_ = false;
+                requestCommandFlush();
             }
 
             if (asked_stop_video_) {
                 ApiCommandPacketPtr api_command_packet_stereo_off = std::make_shared<ApiCommandPacket>(
                         ApiCommandPacket::CommandType::TURN_OFF_API_RAW_STEREO_CAMERA_PACKET);
 
-                sendPacketListAccess_.lock();
-                sendPacketList_.emplace_back(api_command_packet_stereo_off);
-                sendPacketListAccess_.unlock();
+                asked_stop_video_ = not commandQueue_.push(api_command_packet_stereo_off, SendPolicy::NEVER_DROP);
 
-                asked_stop_video_ = false;
+                requestCommandFlush();
             }
         }
 
@@ -256,15 +285,21 @@ Core::graphic_thread() {
 
         SDL_RenderFillRect(renderer_, &background);
 
+        // every sensor is read once per frame, without waiting for the network thread
+        HaLidarPacketPtr ha_lidar_packet_ptr = ha_lidar_packet_.snapshot().value;
+        HaGyroPacketPtr ha_gyro_packet_ptr = ha_gyro_packet_.snapshot().value;
+        HaAcceleroPacketPtr ha_accel_packet_ptr = ha_accel_packet_.snapshot().value;
+        HaOdoPacketPtr ha_odo_packet_ptr = ha_odo_packet_.snapshot().value;
+        HaGpsPacketPtr ha_gps_packet_ptr = ha_gps_packet_.snapshot().value;
+        ApiPostPacketPtr api_post_packet_ptr = api_post_packet_.snapshot().value;
+
         draw_robot();
 
         uint16_t lidar_distance_[271];
 
-        ha_lidar_packet_ptr_access_.lock();
-
-        if (ha_lidar_packet_ptr_ != nullptr) {
+        if (ha_lidar_packet_ptr != nullptr) {
             for (int i = 0; i < 271; i++) {
-                lidar_distance_[i] = ha_lidar_packet_ptr_->distance[i];
+                lidar_distance_[i] = ha_lidar_packet_ptr->distance[i];
             }
         } else {
             for (int i = 0; i < 271; i++) {
@@ -272,8 +307,6 @@ Core::graphic_thread() {
             }
         }
 
-        ha_lidar_packet_ptr_access_.unlock();
-
         draw_lidar(lidar_distance_);
 
         draw_images();
@@ -283,10 +316,6 @@ Core::graphic_thread() {
         // ##############################################
         char gyro_buff[100];
 
-        ha_gyro_packet_ptr_access_.lock();
-        HaGyroPacketPtr ha_gyro_packet_ptr = ha_gyro_packet_ptr_;
-        ha_gyro_packet_ptr_access_.unlock();
-
         if (ha_gyro_packet_ptr != nullptr) {
             snprintf(gyro_buff, sizeof(gyro_buff), "Gyro  : %d ; %d, %d", ha_gyro_packet_ptr->x, ha_gyro_packet_ptr->y,
                      ha_gyro_packet_ptr->z);
@@ -296,10 +325,6 @@ Core::graphic_thread() {
             snprintf(gyro_buff, sizeof(gyro_buff), "Gyro  : N/A ; N/A, N/A");
         }
 
-        ha_accel_packet_ptr_access_.lock();
-        HaAcceleroPacketPtr ha_accel_packet_ptr = ha_accel_packet_ptr_;
-        ha_accel_packet_ptr_access_.unlock();
-
         char accel_buff[100];
         if (ha_accel_packet_ptr != nullptr) {
             snprintf(accel_buff, sizeof(accel_buff), "Accel : %d ; %d, %d", ha_accel_packet_ptr->x,
@@ -310,10 +335,6 @@ Core::graphic_thread() {
             snprintf(accel_buff, sizeof(accel_buff), "Accel : N/A ; N/A, N/A");
         }
 
-        ha_odo_packet_ptr_access.lock();
-        HaOdoPacketPtr ha_odo_packet_ptr = ha_odo_packet_ptr_;
-        ha_odo_packet_ptr_access.unlock();
-
         char odo_buff[100];
         if (ha_odo_packet_ptr != nullptr) {
             snprintf(odo_buff, sizeof(odo_buff), "ODO -> RF : %d ; RR : %d ; RL : %d, FL : %d", ha_odo_packet_ptr->fr,
@@ -325,15 +346,11 @@ Core::graphic_thread() {
             snprintf(odo_buff, sizeof(odo_buff), "ODO -> RF : N/A ; RR : N/A ; RL : N/A, FL : N/A");
         }
 
-        ha_gps_packet_ptr_access_.lock();
-        HaGpsPacketPtr ha_gps_packet_ptr = ha_gps_packet_ptr_;
-        ha_gps_packet_ptr_access_.unlock();
-
         char gps1_buff[100];
         char gps2_buff[100];
         char info[150];
         char info2[150];
-        if (ha_gps_packet_ptr_ != nullptr) {
+        if (ha_gps_packet_ptr != nullptr) {
             snprintf(gps1_buff, sizeof(gps1_buff), "GPS -> lat : %lf ; lon : %lf ; alt : %lf", ha_gps_packet_ptr->lat,
                      ha_gps_packet_ptr->lon, ha_gps_packet_ptr->alt);
             snprintf(gps2_buff, sizeof(gps2_buff), "GPS -> nbsat : %d ; fixlvl : %d ; speed : %lf ",
@@ -360,12 +377,6 @@ Core::graphic_thread() {
         tic_detection(ha_odo_packet_ptr);
 
         // ##############################################
-        ApiPostPacketPtr api_post_packet_ptr = nullptr;
-
-        api_post_packet_ptr_access_.lock();
-        api_post_packet_ptr = api_post_packet_ptr_;
-        api_post_packet_ptr_access_.unlock();
-
         if (api_post_packet_ptr != nullptr) {
             for (uint i = 0; i < api_post_packet_ptr->postList.size(); i++) {
                 if (api_post_packet_ptr->postList[i].postType == ApiPostPacket::PostType::RED) {
@@ -429,88 +440,20 @@ Core::graphic_thread() {
 
 // #################################################
 //
-void Core::draw_text(char buffer[100], int x, int y) {
-    SDL_Surface *surfaceMessageAccel = TTF_RenderText_Solid(ttf_font_, buffer, sdl_color_white_);
-    SDL_Texture *messageAccel = SDL_CreateTextureFromSurface(renderer_, surfaceMessageAccel);
-
-    SDL_FreeSurface(surfaceMessageAccel);
-
-    SDL_Rect message_rect_accel;
-    message_rect_accel.x = x;
-    message_rect_accel.y = y;
-
-    SDL_QueryTexture(messageAccel, NULL, NULL, &message_rect_accel.w, &message_rect_accel.h);
-    SDL_RenderCopy(renderer_, messageAccel, NULL, &message_rect_accel);
+void Core::draw_text(const char *text, int x, int y) {
+    textRenderer_.draw(text, x, y);
+}
 
-    SDL_DestroyTexture(messageAccel);
+// #################################################
+//
+void Core::draw_label(const char *text, int x, int y) {
+    textRenderer_.drawLabel(text, x, y);
 }
 
 // #################################################
 //
 void Core::draw_lidar(uint16_t lidar_distance_[271]) {
-    zoneDetection_gauche = 0;
-    zoneDetection_milieu = 0;
-    zoneDetection_droite = 0;
-    detectionObject_gauche = false;
-    detectionObject_milieu = false;
-    detectionObject_droite = false;
-    for (int i = 0; i < 271; i++) {
-        double dist = static_cast<double>( lidar_distance_[i] ) / 10.0f;
-
-        if (dist < 3.0f) {
-            dist = 5000.0f;
-        }
-
-        if (i > 45 && i < 226) {
-            double x_cos = dist * cos(static_cast<double>((i - 45) * M_PI / 180. ));
-            double y_sin = dist * sin(static_cast<double>((i - 45) * M_PI / 180. ));
-
-            double x = 400.0 - x_cos;
-            double y = 400.0 - y_sin;
-
-            SDL_SetRenderDrawColor(renderer_, 255, 255, 255, 255);
-            SDL_Rect lidar_pixel;
-
-            lidar_pixel.w = 1;
-            lidar_pixel.h = 1;
-            lidar_pixel.x = static_cast<int>( x );
-            lidar_pixel.y = static_cast<int>( y );
-
-            SDL_RenderFillRect(renderer_, &lidar_pixel);
-
-            if (i > 80 && i <= 120) {
-                zoneDetection_gauche += dist;
-                if ((i % 10) == 0) {
-                    if ((zoneDetection_gauche / PAS) < DETECTION) {
-                        detectionObject_gauche = true;
-                    }
-                    zoneDetection_gauche = 0;
-                }
-            }
-
-            if (i > 120 && i <= 160) {
-                zoneDetection_milieu += dist;
-                if ((i % 10) == 0) {
-                    if ((zoneDetection_milieu / PAS) < DETECTION) {
-                        detectionObject_milieu = true;
-                    }
-                    zoneDetection_milieu = 0;
-                }
-            }
-
-            if (i > 160 && i <= 200) {
-                zoneDetection_droite += dist;
-                if ((i % 10) == 0) {
-                    if ((zoneDetection_droite / PAS) < DETECTION) {
-                        detectionObject_droite = true;
-                    }
-                    zoneDetection_droite = 0;
-                }
-            }
-        }
-    }
-
-
+    lidarRenderer_.draw(renderer_, lidar_distance_);
 }
 
 // #################################################
@@ -587,50 +530,126 @@ void Core::draw_robot() {
 // #################################################
 //
 void Core::draw_images() {
-    SDL_Surface *left_image;
-
-    SDL_Surface *right_image;
-
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    Uint32 rmask = 0xff000000;
-    Uint32 gmask = 0x00ff0000;
-    Uint32 bmask = 0x0000ff00;
-    Uint32 amask = 0x000000ff;
-#else
-    Uint32 rmask = 0x000000ff;
-    Uint32 gmask = 0x0000ff00;
-    Uint32 bmask = 0x00ff0000;
-    Uint32 amask = 0xff000000;
-#endif
+    // newest complete frame, the preparer leaves it alone until the next snapshot
+    const LatestValue<StereoFrame>::Snapshot &snapshot = stereoFrames_.snapshot();
 
-    last_images_buffer_access_.lock();
+    if (snapshot.sequence == 0) {
+        return;
+    }
 
-    if (last_image_type_ == ApiStereoCameraPacket::ImageType::RAW_IMAGES or
-        last_image_type_ == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB) {
-        left_image = SDL_CreateRGBSurfaceFrom(last_images_buffer_, 752, 480, 3 * 8, 752 * 3, rmask, gmask, bmask,
-                                              amask);
-        right_image = SDL_CreateRGBSurfaceFrom(last_images_buffer_ + (752 * 480 * 3), 752, 480, 3 * 8, 752 * 3, rmask,
-                                               gmask, bmask, amask);
-    } else {
-        left_image = SDL_CreateRGBSurfaceFrom(last_images_buffer_, 376, 240, 3 * 8, 376 * 3, rmask, gmask, bmask,
-                                              amask);
-        right_image = SDL_CreateRGBSurfaceFrom(last_images_buffer_ + (376 * 240 * 3), 376, 240, 3 * 8, 376 * 3, rmask,
-                                               gmask, bmask, amask);
+    const StereoFrame &frame = snapshot.value;
+
+    bool raw = frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES or
+               frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB;
+
+    int width = raw ? 752 : 376;
+    int height = raw ? 480 : 240;
+
+    // the textures keep the last upload, a frame is sent to the GPU once however often it is drawn
+    if (snapshot.sequence != uploadedFrameSequence_) {
+        uploadImages(frame, width, height);
+
+        uploadedFrameSequence_ = snapshot.sequence;
     }
 
-    last_images_buffer_access_.unlock();
+    displayedFrameSequence_ = snapshot.sequence;
+
+    if (leftImageTexture_ == nullptr or rightImageTexture_ == nullptr) {
+        return;
+    }
 
     SDL_Rect left_rect = {400 - 376 - 10, 485, 376, 240};
 
     SDL_Rect right_rect = {400 + 10, 485, 376, 240};
 
-    SDL_Texture *left_texture = SDL_CreateTextureFromSurface(renderer_, left_image);
+    SDL_RenderCopy(renderer_, leftImageTexture_, NULL, &left_rect);
 
-    SDL_Texture *right_texture = SDL_CreateTextureFromSurface(renderer_, right_image);
+    SDL_RenderCopy(renderer_, rightImageTexture_, NULL, &right_rect);
+}
+
+// #################################################
+//
+void
+Core::uploadImages(const StereoFrame &frame, int width, int height) {
+    size_t imageSize = static_cast<size_t>( width * height );
+
+    if (frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES or
+        frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB) {
+        if (not grayTexturesUnsupported_ and prepareImageTextures(SDL_PIXELFORMAT_IYUV, width, height)) {
+            int chromaPitch = width / 2;
+
+            neutralChromaPlane_.resize(imageSize / 4, 128);
+
+            SDL_UpdateYUVTexture(leftImageTexture_, NULL, frame.pixels.data(), width,
+                                 neutralChromaPlane_.data(), chromaPitch, neutralChromaPlane_.data(), chromaPitch);
+            SDL_UpdateYUVTexture(rightImageTexture_, NULL, frame.pixels.data() + imageSize, width,
+                                 neutralChromaPlane_.data(), chromaPitch, neutralChromaPlane_.data(), chromaPitch);
+
+            return;
+        }
+
+        grayTexturesUnsupported_ = true;
+
+        if (not prepareImageTextures(SDL_PIXELFORMAT_RGB24, width, height)) {
+            return;
+        }
 
-    SDL_RenderCopy(renderer_, left_texture, NULL, &left_rect);
+        grayExpansionBuffer_.resize(imageSize * 2 * 3);
 
-    SDL_RenderCopy(renderer_, right_texture, NULL, &right_rect);
+        grayToRgb(frame.pixels.data(), grayExpansionBuffer_.data(), imageSize * 2);
+
+        SDL_UpdateTexture(leftImageTexture_, NULL, grayExpansionBuffer_.data(), width * 3);
+        SDL_UpdateTexture(rightImageTexture_, NULL, grayExpansionBuffer_.data() + (imageSize * 3), width * 3);
+    } else {
+        if (not prepareImageTextures(SDL_PIXELFORMAT_RGB24, width, height)) {
+            return;
+        }
+
+        SDL_UpdateTexture(leftImageTexture_, NULL, frame.pixels.data(), width * 3);
+        SDL_UpdateTexture(rightImageTexture_, NULL, frame.pixels.data() + (imageSize * 3), width * 3);
+    }
+}
+
+// #################################################
+//
+bool
+Core::prepareImageTextures(Uint32 format, int width, int height) {
+    if (leftImageTexture_ != nullptr and imageTextureFormat_ == format and imageTextureWidth_ == width) {
+        return true;
+    }
+
+    if (leftImageTexture_ != nullptr) {
+        SDL_DestroyTexture(leftImageTexture_);
+    }
+
+    if (rightImageTexture_ != nullptr) {
+        SDL_DestroyTexture(rightImageTexture_);
+    }
+
+    leftImageTexture_ = SDL_CreateTexture(renderer_, format, SDL_TEXTUREACCESS_STREAMING, width, height);
+    rightImageTexture_ = SDL_CreateTexture(renderer_, format, SDL_TEXTUREACCESS_STREAMING, width, height);
+
+    if (leftImageTexture_ == nullptr or rightImageTexture_ == nullptr) {
+        std::cerr << "Failed to create image textures! Error: " << SDL_GetError() << std::endl;
+
+        if (leftImageTexture_ != nullptr) {
+            SDL_DestroyTexture(leftImageTexture_);
+        }
+
+        if (rightImageTexture_ != nullptr) {
+            SDL_DestroyTexture(rightImageTexture_);
+        }
+
+        leftImageTexture_ = nullptr;
+        rightImageTexture_ = nullptr;
+
+        return false;
+    }
+
+    imageTextureFormat_ = format;
+    imageTextureWidth_ = width;
+
+    return true;
 }
 
 // #################################################
@@ -669,6 +688,8 @@ Core::initSDL(const char *name, int szX, int szY) {
         std::cerr << "Failed to load SDL Font! Error: " << TTF_GetError() << '\n';
     }
 
+    textRenderer_.init(renderer_, ttf_font_, sdl_color_white_);
+
     std::cout << "DONE" << std::endl;
 
     return screen;
@@ -678,6 +699,18 @@ Core::initSDL(const char *name, int szX, int szY) {
 //
 void
 Core::exitSDL() {
+    textRenderer_.release();
+
+    if (leftImageTexture_ != nullptr) {
+        SDL_DestroyTexture(leftImageTexture_);
+        leftImageTexture_ = nullptr;
+    }
+
+    if (rightImageTexture_ != nullptr) {
+        SDL_DestroyTexture(rightImageTexture_);
+        rightImageTexture_ = nullptr;
+    }
+
     SDL_Quit();
 }
 
@@ -723,6 +756,9 @@ Core::readSDLKeyboard() {
 //
 bool
 Core::manageSDLKeyboard() {
+    // one view of the zones for all the keys
+    ObstacleDetector::Detection obstacles = obstacleDetector_.getDetection();
+
     bool keyPressed = false;
 
     int8_t left = 0;
@@ -735,40 +771,42 @@ Core::manageSDLKeyboard() {
 
     if (sdlKey_[SDL_SCANCODE_O] == 1) {
         asked_start_video_ = true;
+        videoEnabled_ = true;
     }
 
     if (sdlKey_[SDL_SCANCODE_F] == 1) {
         asked_stop_video_ = true;
+        videoEnabled_ = false;
     }
 
     if (sdlKey_[SDL_SCANCODE_UP] == 1 and sdlKey_[SDL_SCANCODE_LEFT] == 1) {
-        if (!detectionObject_gauche && !detectionObject_milieu) {
+        if (!obstacles.left && !obstacles.middle) {
             left = 32;
             right = 63;
             keyPressed = true;
         }
     } else if (sdlKey_[SDL_SCANCODE_UP] == 1 and sdlKey_[SDL_SCANCODE_RIGHT] == 1) {
-        if (!detectionObject_droite && !detectionObject_milieu) {
+        if (!obstacles.right && !obstacles.middle) {
             left = 63;
             right = 32;
             keyPressed = true;
         }
 
     } else if (sdlKey_[SDL_SCANCODE_DOWN] == 1 and sdlKey_[SDL_SCANCODE_LEFT] == 1) {
-        if (!detectionObject_gauche) {
+        if (!obstacles.left) {
             left = -32;
             right = -63;
             keyPressed = true;
         }
     } else if (sdlKey_[SDL_SCANCODE_DOWN] == 1 and sdlKey_[SDL_SCANCODE_RIGHT] == 1) {
-        if (!detectionObject_droite) {
+        if (!obstacles.right) {
             left = -63;
             right = -32;
             keyPressed = true;
         }
 
     } else if (sdlKey_[SDL_SCANCODE_UP] == 1) {
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             left = 63;
             right = 63;
             keyPressed = true;
@@ -779,13 +817,13 @@ Core::manageSDLKeyboard() {
         keyPressed = true;
 
     } else if (sdlKey_[SDL_SCANCODE_LEFT] == 1) {
-        if (!detectionObject_gauche) {
+        if (!obstacles.left) {
             left = -63;
             right = 63;
             keyPressed = true;
         }
     } else if (sdlKey_[SDL_SCANCODE_RIGHT] == 1) {
-        if (!detectionObject_droite) {
+        if (!obstacles.right) {
             left = 63;
             right = -63;
             keyPressed = true;
@@ -799,19 +837,19 @@ Core::manageSDLKeyboard() {
             && mouse_pos_y < box.y + box.h) {
             switch (button_selected) {
                 case 0: // Up
-                    if (!detectionObject_milieu) {
+                    if (!obstacles.middle) {
                         left = 10;
                         right = 10;
                     }
                     break;
                 case 1: // Left
-                    if (!detectionObject_gauche) {
+                    if (!obstacles.left) {
                         left = 10;
                         right = 63;
                     }
                     break;
                 case 2: // Right
-                    if (!detectionObject_droite) {
+                    if (!obstacles.right) {
                         left = 63;
                         right = 10;
                     }
@@ -850,14 +888,11 @@ Core::manageSDLKeyboard() {
         }
     }
     // COMMANDE MOTEUR
-    last_motor_access_.lock();
-    last_left_motor_ = static_cast<int8_t >( left * 2 );
-    last_right_motor_ = static_cast<int8_t >( right * 2 );
-    last_motor_access_.unlock();
+    setMotorSetPoint(static_cast<int8_t >( left * 2 ), static_cast<int8_t >( right * 2 ));
 
     // deplacement d'un longeur de rangée
     if (mode_automatique && (dist_rl < pos_init + distance_a_parcourir) && range1) {
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             printf("Mode automatique: Objet non detecte Longueur rangée\n");
             deplacement(1);
         } else {
@@ -869,7 +904,7 @@ Core::manageSDLKeyboard() {
         //premier virage
     else if (mode_automatique && (virage_var < 200) && vir1) {
         range1 = false;
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             printf("Mode automatique: Objet non detecte virage\n");
             virage('g');
             virage_var++;
@@ -882,7 +917,7 @@ Core::manageSDLKeyboard() {
     } else if (mode_automatique && (marche_arriere < 400) && range2) {
         vir1 = false;
         virage_var = 0;
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             printf("Mode automatique: Objet non detecte Longueur rangée\n");
             deplacement(-1);
             marche_arriere++;
@@ -893,7 +928,7 @@ Core::manageSDLKeyboard() {
         //deuxieme virage
     } else if (mode_automatique && (virage_var < 200) && vir2) {
         range2 = false;
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             printf("Mode automatique: Objet non detecte virage\n");
             virage('g');
             virage_var++;
@@ -905,7 +940,7 @@ Core::manageSDLKeyboard() {
         // retour
     } else if (mode_automatique && (dist_rl < post_demi + distance_a_parcourir) && range1) {
         vir1 = false;
-        if (!detectionObject_milieu) {
+        if (!obstacles.middle) {
             printf("Mode automatique: Objet non detecte Longueur rangée\n");
             deplacement(1);
         } else {
@@ -926,57 +961,77 @@ Core::manageSDLKeyboard() {
 // #################################################
 //
 void
-Core::manageReceivedPacket(BaseNaio01PacketPtr packetPtr) {
-    //std::cout << "Packet received id : " << static_cast<int>( packetPtr->getPacketId() ) << std::endl;
-
-    if (std::dynamic_pointer_cast<HaLidarPacket>(packetPtr)) {
-        HaLidarPacketPtr haLidarPacketPtr = std::dynamic_pointer_cast<HaLidarPacket>(packetPtr);
-
-        ha_lidar_packet_ptr_access_.lock();
-        ha_lidar_packet_ptr_ = haLidarPacketPtr;
-        ha_lidar_packet_ptr_access_.unlock();
-    } else if (std::dynamic_pointer_cast<HaGyroPacket>(packetPtr)) {
-        HaGyroPacketPtr haGyroPacketPtr = std::dynamic_pointer_cast<HaGyroPacket>(packetPtr);
-
-        ha_gyro_packet_ptr_access_.lock();
-        ha_gyro_packet_ptr_ = haGyroPacketPtr;
-        ha_gyro_packet_ptr_access_.unlock();
-    } else if (std::dynamic_pointer_cast<HaAcceleroPacket>(packetPtr)) {
-        HaAcceleroPacketPtr haAcceleroPacketPtr = std::dynamic_pointer_cast<HaAcceleroPacket>(packetPtr);
-
-        ha_accel_packet_ptr_access_.lock();
-        ha_accel_packet_ptr_ = haAcceleroPacketPtr;
-        ha_accel_packet_ptr_access_.unlock();
-    } else if (std::dynamic_pointer_cast<HaOdoPacket>(packetPtr)) {
-        HaOdoPacketPtr haOdoPacketPtr = std::dynamic_pointer_cast<HaOdoPacket>(packetPtr);
-
-        ha_odo_packet_ptr_access.lock();
-        ha_odo_packet_ptr_ = haOdoPacketPtr;
-        ha_odo_packet_ptr_access.unlock();
-    } else if (std::dynamic_pointer_cast<ApiPostPacket>(packetPtr)) {
-        ApiPostPacketPtr apiPostPacketPtr = std::dynamic_pointer_cast<ApiPostPacket>(packetPtr);
-
-        api_post_packet_ptr_access_.lock();
-        api_post_packet_ptr_ = apiPostPacketPtr;
-        api_post_packet_ptr_access_.unlock();
-    } else if (std::dynamic_pointer_cast<HaGpsPacket>(packetPtr)) {
-        HaGpsPacketPtr haGpsPacketPtr = std::dynamic_pointer_cast<HaGpsPacket>(packetPtr);
-
-        ha_gps_packet_ptr_access_.lock();
-        ha_gps_packet_ptr_ = haGpsPacketPtr;
-        ha_gps_packet_ptr_access_.unlock();
-    } else if (std::dynamic_pointer_cast<ApiStereoCameraPacket>(packetPtr)) {
-        ApiStereoCameraPacketPtr api_stereo_camera_packet_ptr = std::dynamic_pointer_cast<ApiStereoCameraPacket>(
-                packetPtr);
-
-        milliseconds now_ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-        last_image_received_time_ = static_cast<int64_t>( now_ms.count());
+Core::registerPacketHandlers() {
+    naioCodec_.onPacket<HaLidarPacket>([this](const HaLidarPacketPtr &packetPtr) {
+        int64_t now = static_cast<int64_t>( duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
 
-        api_stereo_camera_packet_ptr_access_.lock();
-        api_stereo_camera_packet_ptr_ = api_stereo_camera_packet_ptr;
-        api_stereo_camera_packet_ptr_access_.unlock();
-    }
+        // the robot has to stop on this scan, not at the next frame or keep-alive
+        if (obstacleDetector_.processScan(packetPtr->distance, now)) {
+            requestMotorSend();
+        }
+
+        ha_lidar_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<HaGyroPacket>([this](const HaGyroPacketPtr &packetPtr) {
+        ha_gyro_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<HaAcceleroPacket>([this](const HaAcceleroPacketPtr &packetPtr) {
+        ha_accel_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<HaOdoPacket>([this](const HaOdoPacketPtr &packetPtr) {
+        ha_odo_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<ApiPostPacket>([this](const ApiPostPacketPtr &packetPtr) {
+        api_post_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<HaGpsPacket>([this](const HaGpsPacketPtr &packetPtr) {
+        ha_gps_packet_.publish(packetPtr);
+    });
+
+    naioCodec_.onPacket<ApiStereoCameraPacket>([this](const ApiStereoCameraPacketPtr &packetPtr) {
+        manageReceivedImage(packetPtr);
+    });
+
+    // images are decoded straight into the frames of the ring, allocated only when all are in use
+    ApiStereoCameraPacket::DataBufferProvider frameProvider = [this](size_t dataSize) {
+        return stereoFrameRing_.acquire(dataSize);
+    };
+
+    imageNaioCodec_.registerPacketType(
+            static_cast<uint8_t>( Naio01Codec::Naio01CodecPacketType::API_RAW_STEREO_CAMERA ),
+            [frameProvider]() -> BaseNaio01PacketPtr {
+                return std::make_shared<ApiStereoCameraPacket>(frameProvider);
+            });
+
+    // zlib images are inflated as they come in, the preparer only converts them
+    imageNaioCodec_.setPayloadStreamHandler(
+            static_cast<uint8_t>( Naio01Codec::Naio01CodecPacketType::API_RAW_STEREO_CAMERA ),
+            [this](const uint8_t *fragment, uint32_t offset, uint32_t size, uint32_t payloadSize) {
+                imageInflater_.onPayloadFragment(fragment, offset, size, payloadSize);
+            });
 
+    imageNaioCodec_.onPacket<ApiStereoCameraPacket>([this](const ApiStereoCameraPacketPtr &packetPtr) {
+        imageInflater_.takeInflated(*packetPtr);
+
+        manageReceivedImage(packetPtr);
+    });
+}
+
+// #################################################
+//
+void
+Core::manageReceivedImage(const ApiStereoCameraPacketPtr &packetPtr) {
+    api_stereo_camera_packet_ptr_access_.lock();
+    api_stereo_camera_packet_ptr_ = packetPtr;
+    api_stereo_camera_packet_ptr_access_.unlock();
+
+    // the preparer starts on it at once, a frame it did not take yet is replaced
+    api_stereo_camera_packet_ready_.notify_one();
 }
 
 // #################################################
@@ -988,288 +1043,338 @@ Core::joinMainThread() {
 
 // #################################################
 //
-void Core::joinServerReadThread() {
-    serverReadThread_.join();
+void Core::joinNetworkThread() {
+    networkThread_.join();
 }
 
 // #################################################
 //
-void Core::image_server_thread() {
-    imageServerReadthreadStarted_ = false;
-    imageServerWriteThreadStarted_ = false;
-
-    stopImageServerReadThreadAsked_ = false;
-    stopImageServerWriteThreadAsked_ = false;
-
-    stopImageServerThreadAsked_ = false;
-    imageServerThreadStarted_ = true;
-
-    struct sockaddr_in imageServer;
-
-    //Create socket
-    image_socket_desc_ = socket(AF_INET, SOCK_STREAM, 0);
-
-    if (image_socket_desc_ == -1) {
-        std::cout << "Could not create socket" << std::endl;
-    }
-
-    imageServer.sin_addr.s_addr = inet_addr(hostAdress_.c_str());
-    imageServer.sin_family = AF_INET;
-    imageServer.sin_port = htons(static_cast<uint16_t>( hostPort_ + 2 ));
-
-    //Connect to remote server
-    if (connect(image_socket_desc_, (struct sockaddr *) &imageServer, sizeof(imageServer)) < 0) {
-        puts("image connect error");
-    } else {
-        puts("Connected image\n");
-        imageSocketConnected_ = true;
+// a new connection starts a new session : the robot knows nothing of the previous one
+void Core::onServerConnected() {
+    // bytes of a packet cut by the disconnection would be glued to the new stream
+    naioCodec_.reset();
+
+    // one stop frame is enough on TCP, the keep-alive repeats it until the user drives
+    ApiMotorsPacketPtr first_packet = std::make_shared<ApiMotorsPacket>(0, 0);
+    first_packet->encodeTo(sendSink_);
+
+    if (videoEnabled_) {
+        ApiCommandPacketPtr api_command_packet_zlib_off = std::make_shared<ApiCommandPacket>(
+                ApiCommandPacket::CommandType::TURN_OFF_IMAGE_ZLIB_COMPRESSION);
+        ApiCommandPacketPtr api_command_packet_stereo_on = std::make_shared<ApiCommandPacket>(
+                ApiCommandPacket::CommandType::TURN_ON_API_RAW_STEREO_CAMERA_PACKET);
+
+        api_command_packet_zlib_off->encodeTo(sendSink_);
+        api_command_packet_stereo_on->encodeTo(sendSink_);
     }
 
-    image_prepared_thread_ = std::thread(&Core::image_preparer_thread, this);
+    flushCommandSocket();
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>( 50 )));
-
-    imageServerReadThread_ = std::thread(&Core::image_server_read_thread, this);
+    sendMotorSetPoint();
+}
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>( 50 )));
+// #################################################
+//
+void Core::onServerDisconnected() {
+    // half sent packets are meaningless on the next connection
+    sendSink_.clear();
 
-    imageServerWriteThread_ = std::thread(&Core::image_server_write_thread, this);
+    int64_t stallStart = commandStallStartMs_;
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>( 50 )));
+    if (stallStart >= 0) {
+        int64_t now = static_cast<int64_t>( duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
 
-    while (not stopImageServerThreadAsked_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>( 500 )));
+        commandStallTotalMs_ += now - stallStart;
+        commandStallStartMs_ = -1;
     }
-
-    imageServerThreadStarted_ = false;
-    stopImageServerThreadAsked_ = false;
 }
 
 // #################################################
 //
-void Core::image_server_read_thread() {
-    imageServerReadthreadStarted_ = true;
+bool Core::readAndDecode(ServerConnection &connection, Naio01Codec &codec) {
+    ssize_t readSize = read(connection.socketDesc(), receiveBuffer_.data(), receiveBuffer_.size());
 
-    uint8_t receiveBuffer[4000000];
+    if (readSize > 0) {
+        rearmQuickAck(connection.socketDesc(), connection.options());
 
-    while (!stopImageServerReadThreadAsked_) {
-        // any time : read incoming messages.
-        int readSize = (int) read(image_socket_desc_, receiveBuffer, 4000000);
+        connection.markAlive();
 
-        if (readSize > 0) {
-            bool packetHeaderDetected = false;
+        bool packetHeaderDetected = false;
 
-            bool atLeastOnePacketReceived = imageNaioCodec_.decode(receiveBuffer, static_cast<uint>( readSize ),
-                                                                   packetHeaderDetected);
+        // known packets go straight to their handlers, drop the others
+        codec.decode(receiveBuffer_.data(), static_cast<uint>( readSize ), packetHeaderDetected);
 
-            // manage received messages
-            if (atLeastOnePacketReceived) {
-                for (auto &&packetPtr : imageNaioCodec_.currentBasePacketList) {
-                    if (std::dynamic_pointer_cast<ApiStereoCameraPacket>(packetPtr)) {
-                        ApiStereoCameraPacketPtr api_stereo_camera_packet_ptr = std::dynamic_pointer_cast<ApiStereoCameraPacket>(
-                                packetPtr);
-
-                        milliseconds now_ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-                        last_image_received_time_ = static_cast<int64_t>( now_ms.count());
-
-                        api_stereo_camera_packet_ptr_access_.lock();
-                        api_stereo_camera_packet_ptr_ = api_stereo_camera_packet_ptr;
-                        api_stereo_camera_packet_ptr_access_.unlock();
-                    }
-                }
+        codec.currentBasePacketList.clear();
 
-                imageNaioCodec_.currentBasePacketList.clear();
-            }
-        }
-
-        std::this_thread::sleep_for(
-                std::chrono::milliseconds(static_cast<int64_t>( WAIT_SERVER_IMAGE_TIME_RATE_MS )));
+        return true;
     }
 
-    imageServerReadthreadStarted_ = false;
-    stopImageServerReadThreadAsked_ = false;
+    return readSize < 0 and (errno == EAGAIN or errno == EINTR);
 }
 
 // #################################################
 // use only for server socket watchdog
-void Core::image_server_write_thread() {
-    imageServerWriteThreadStarted_ = true;
+void Core::sendImageWatchdog() {
+    if (imageConnection_.isConnected()) {
+        ApiWatchdogPacketPtr api_watchdog_packet_ptr = std::make_shared<ApiWatchdogPacket>(42);
 
-    while (!stopImageServerWriteThreadAsked_) {
-        if (imageSocketConnected_) {
-            ApiWatchdogPacketPtr api_watchdog_packet_ptr = std::make_shared<ApiWatchdogPacket>(42);
+        cl_copy::BufferUPtr buffer = api_watchdog_packet_ptr->encode();
 
-            cl_copy::BufferUPtr buffer = api_watchdog_packet_ptr->encode();
+        // a broken link is seen by the read side, it must not raise SIGPIPE here
+        ssize_t sentSize = send(imageConnection_.socketDesc(), buffer->data(), buffer->size(), MSG_NOSIGNAL);
 
-            write(image_socket_desc_, buffer->data(), buffer->size());
-        }
-
-        std::this_thread::sleep_for(
-                std::chrono::milliseconds(static_cast<int64_t>( IMAGE_SERVER_WATCHDOG_SENDING_RATE_MS )));
+        (void) sentSize;
     }
-
-    imageServerWriteThreadStarted_ = false;
-    stopImageServerWriteThreadAsked_ = false;
 }
 
 // #################################################
 //
 void Core::image_preparer_thread() {
-    Bytef zlibUncompressedBytes[4000000l];
+    // a raw stereo pair is 2 gray images, a colorized one fills the whole RGB buffer
+    std::vector<Bytef> zlibUncompressedBytes(STEREO_FRAME_MAX_SIZE);
+
+    // the test pattern is drawn once, after that the thread sleeps until an image comes
+    bool patternShown = false;
+
+    auto frameOrStop = [this]() { return api_stereo_camera_packet_ptr_ != nullptr or imagePreparerStopAsked_; };
 
     while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>( IMAGE_PREPARING_RATE_MS )));
+        std::unique_lock<std::mutex> lock(api_stereo_camera_packet_ptr_access_);
 
-        ApiStereoCameraPacketPtr api_stereo_camera_packet_ptr = nullptr;
+        if (patternShown) {
+            api_stereo_camera_packet_ready_.wait(lock, frameOrStop);
+        } else {
+            api_stereo_camera_packet_ready_.wait_for(lock, milliseconds(TIME_BEFORE_IMAGE_LOST_MS), frameOrStop);
+        }
 
-        api_stereo_camera_packet_ptr_access_.lock();
+        if (imagePreparerStopAsked_) {
+            break;
+        }
 
-        if (api_stereo_camera_packet_ptr_ != nullptr) {
-            last_image_type_ = api_stereo_camera_packet_ptr_->imageType;
+        // leaves nullptr behind
+        ApiStereoCameraPacketPtr api_stereo_camera_packet_ptr = std::move(api_stereo_camera_packet_ptr_);
 
-            api_stereo_camera_packet_ptr = api_stereo_camera_packet_ptr_;
+        lock.unlock();
 
-            api_stereo_camera_packet_ptr_ = nullptr;
-        }
+        // the renderer never sees this frame before publishBack
+        StereoFrame &frame = stereoFrames_.back();
 
-        api_stereo_camera_packet_ptr_access_.unlock();
+        frame.pixels.resize(STEREO_FRAME_MAX_SIZE);
 
         if (api_stereo_camera_packet_ptr != nullptr) {
             cl_copy::BufferUPtr bufferUPtr = std::move(api_stereo_camera_packet_ptr->dataBuffer);
 
-            if (last_image_type_ == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB or
-                last_image_type_ == ApiStereoCameraPacket::ImageType::RECTIFIED_COLORIZED_IMAGES_ZLIB) {
-                uLong sizeDataUncompressed = 0l;
+            frame.imageType = api_stereo_camera_packet_ptr->imageType;
 
-                uncompress((Bytef *) zlibUncompressedBytes, &sizeDataUncompressed, bufferUPtr->data(),
-                           static_cast<uLong>( bufferUPtr->size()));
+            const uint8_t *data = bufferUPtr->data();
+            size_t dataSize = bufferUPtr->size();
 
-                last_images_buffer_access_.lock();
+            if (frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB or
+                frame.imageType == ApiStereoCameraPacket::ImageType::RECTIFIED_COLORIZED_IMAGES_ZLIB) {
+                // only when the image could not be inflated while received
+                uLong sizeDataUncompressed = static_cast<uLong>( zlibUncompressedBytes.size());
 
-                if (last_image_type_ == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB) {
-                    // don't know how to display 8bits image with sdl...
-                    for (uint i = 0; i < sizeDataUncompressed; i++) {
-                        last_images_buffer_[(i * 3) + 0] = zlibUncompressedBytes[i];
-                        last_images_buffer_[(i * 3) + 1] = zlibUncompressedBytes[i];
-                        last_images_buffer_[(i * 3) + 2] = zlibUncompressedBytes[i];
-                    }
-                } else {
-                    for (uint i = 0; i < sizeDataUncompressed; i++) {
-                        last_images_buffer_[i] = zlibUncompressedBytes[i];
-                    }
-                }
+                int result = uncompress(zlibUncompressedBytes.data(), &sizeDataUncompressed, bufferUPtr->data(),
+                                        static_cast<uLong>( bufferUPtr->size()));
 
-                last_images_buffer_access_.unlock();
-            } else {
-                last_images_buffer_access_.lock();
-
-                if (last_image_type_ == ApiStereoCameraPacket::ImageType::RAW_IMAGES) {
-                    // don't know how to display 8bits image with sdl...
-                    for (uint i = 0; i < bufferUPtr->size(); i++) {
-                        last_images_buffer_[(i * 3) + 0] = bufferUPtr->at(i);
-                        last_images_buffer_[(i * 3) + 1] = bufferUPtr->at(i);
-                        last_images_buffer_[(i * 3) + 2] = bufferUPtr->at(i);
-                    }
-                } else {
-                    for (uint i = 0; i < bufferUPtr->size(); i++) {
-                        last_images_buffer_[i] = bufferUPtr->at(i);
-                    }
+                // truncated or corrupted : the frame is dropped, the last one stays on screen
+                if (result != Z_OK) {
+                    continue;
                 }
 
-                last_images_buffer_access_.unlock();
+                data = zlibUncompressedBytes.data();
+                dataSize = sizeDataUncompressed;
             }
-        } else {
-            milliseconds now_ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-            int64_t now = static_cast<int64_t>( now_ms.count());
-
-            int64_t diff_time = now - last_image_received_time_;
-
-            if (diff_time > TIME_BEFORE_IMAGE_LOST_MS) {
-                last_image_received_time_ = now;
 
-                uint8_t fake = 0;
+            if (frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES or
+                frame.imageType == ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB) {
+                // kept gray, displayed as the Y plane of IYUV textures
+                std::memcpy(frame.pixels.data(), data, std::min(dataSize, STEREO_FRAME_MAX_SIZE / 3));
+            } else {
+                std::memcpy(frame.pixels.data(), data, std::min(dataSize, frame.pixels.size()));
+            }
 
-                last_images_buffer_access_.lock();
+            stereoFrames_.publishBack();
 
-                for (int i = 0; i < 721920 * 3; i++) {
-                    if (fake >= 255) {
-                        fake = 0;
-                    }
+            patternShown = false;
+        } else {
+            // no image for TIME_BEFORE_IMAGE_LOST_MS, test pattern until the next one
+            frame.imageType = ApiStereoCameraPacket::ImageType::RAW_IMAGES;
 
-                    last_images_buffer_[i] = fake;
+            uint8_t fake = 0;
 
-                    fake++;
+            for (size_t i = 0; i < 721920; i++) {
+                if (fake >= 255) {
+                    fake = 0;
                 }
 
-                last_images_buffer_access_.unlock();
+                frame.pixels[i] = fake;
+
+                fake++;
             }
+
+            stereoFrames_.publishBack();
+
+            patternShown = true;
         }
     }
+
+    std::cout << "Stopping image preparer thread." << std::endl;
+}
+
+// #################################################
+//
+void Core::stopImagePreparerThread() {
+    if (image_prepared_thread_.joinable()) {
+        api_stereo_camera_packet_ptr_access_.lock();
+        imagePreparerStopAsked_ = true;
+        api_stereo_camera_packet_ptr_access_.unlock();
+
+        api_stereo_camera_packet_ready_.notify_one();
+
+        image_prepared_thread_.join();
+    }
 }
 
 // #################################################
 //
 //COMMANDE DU ROBOT
-void Core::server_write_thread() {
-    stopServerWriteThreadAsked_ = false;
-    serverWriteThreadStarted_ = true;
-
-    for (int i = 0; i < 100; i++) {
-        ApiMotorsPacketPtr first_packet = std::make_shared<ApiMotorsPacket>(0, 0);
-        cl_copy::BufferUPtr first_buffer = first_packet->encode();
-        write(socket_desc_, first_buffer->data(), first_buffer->size());
+void Core::sendMotorSetPoint() {
+    motorSendPending_ = false;
+
+    //direction calculation
+    if (last_left_motor_ > 0 && last_right_motor_ > 0) {
+        dir_f = true;
+        dir_r = false;
+    }
+    if (last_left_motor_ < 0 && last_right_motor_ < 0) {
+        dir_f = false;
+        dir_r = true;
+    }
+    if (last_left_motor_ == 0 || last_right_motor_ == 0) {
+        dir_f = false;
+        dir_r = false;
+    }
+    last_motor_access_.lock();
+    //Si je détecte beaucoup de point alors
+    if (obstacleDetector_.getDetection().any()) {
+        //arrêt du robot
+        // COMMANDE MOTEUR
+        //last_motor_access_.lock();
+        last_left_motor_ = static_cast<int8_t >(0);
+        last_right_motor_ = static_cast<int8_t >(0);
+        //last_motor_access_.unlock();
+        printf("OBJECT DETECTED\n");
     }
+    HaMotorsPacketPtr haMotorsPacketPtr = std::make_shared<HaMotorsPacket>(last_left_motor_, last_right_motor_);
 
-    while (not stopServerWriteThreadAsked_) {
-        //direction calculation
-        if (last_left_motor_ > 0 && last_right_motor_ > 0) {
-            dir_f = true;
-            dir_r = false;
-        }
-        if (last_left_motor_ < 0 && last_right_motor_ < 0) {
-            dir_f = false;
-            dir_r = true;
-        }
-        if (last_left_motor_ == 0 || last_right_motor_ == 0) {
-            dir_f = false;
-            dir_r = false;
-        }
-        last_motor_access_.lock();
-        //Si je détecte beaucoup de point alors
-        if (detectionObject_droite || detectionObject_milieu || detectionObject_gauche) {
-            //arrêt du robot
-            // COMMANDE MOTEUR
-            //last_motor_access_.lock();
-            last_left_motor_ = static_cast<int8_t >(0);
-            last_right_motor_ = static_cast<int8_t >(0);
-            //last_motor_access_.unlock();
-            printf("OBJECT DETECTED\n");
-        }
-        HaMotorsPacketPtr haMotorsPacketPtr = std::make_shared<HaMotorsPacket>(last_left_motor_, last_right_motor_);
+    last_motor_access_.unlock();
+
+    // a set-point still waiting for a stalled link is replaced by this one
+    commandQueue_.push(haMotorsPacketPtr, SendPolicy::DROP_OLDEST);
 
-        last_motor_access_.unlock();
+    flushCommandSocket();
+
+    // unchanged set-points are only repeated to keep the robot watchdog fed, the next connection
+    // starts them again
+    if (commandConnection_.isConnected()) {
+        eventLoop_.armTimer(motorKeepAliveTimer_, MOTOR_KEEP_ALIVE_RATE_MS);
+    }
+}
 
-        sendPacketListAccess_.lock();
+// #################################################
+// any thread
+void Core::setMotorSetPoint(int8_t left, int8_t right) {
+    last_motor_access_.lock();
 
-        sendPacketList_.push_back(haMotorsPacketPtr);
+    bool changed = left != last_left_motor_ or right != last_right_motor_;
 
-        for (auto &&packet : sendPacketList_) {
-            cl_copy::BufferUPtr buffer = packet->encode();
+    last_left_motor_ = left;
+    last_right_motor_ = right;
 
-            int sentSize = (int) write(socket_desc_, buffer->data(), buffer->size());
+    last_motor_access_.unlock();
 
-            (void) sentSize;
+    if (changed) {
+        requestMotorSend();
+    }
+}
+
+// #################################################
+// any thread : the set-point goes out now instead of at the next keep-alive
+void Core::requestMotorSend() {
+    if (not motorSendPending_.exchange(true)) {
+        eventLoop_.post([this]() { sendMotorSetPoint(); });
+    }
+}
+
+// #################################################
+// any thread
+void Core::requestCommandFlush() {
+    eventLoop_.post([this]() { flushCommandSocket(); });
+}
+
+// #################################################
+// the whole queue goes out in one system call, never blocking the loop
+void Core::flushCommandSocket() {
+    if (not commandConnection_.isConnected()) {
+        return;
+    }
+
+    // while stalled, new packets wait in the bounded queue where set-points coalesce
+    if (sendSink_.empty()) {
+        commandQueue_.drainTo(sendSink_);
+    }
+
+    if (sendSink_.empty()) {
+        return;
+    }
+
+    if (not sendSink_.flush(commandConnection_.socketDesc())) {
+        commandConnection_.reconnect("send error");
+
+        return;
+    }
+
+    int64_t now = static_cast<int64_t>( duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    int64_t stallStart = commandStallStartMs_;
+
+    if (sendSink_.empty()) {
+        if (stallStart >= 0) {
+            commandStallTotalMs_ += now - stallStart;
+            commandStallStartMs_ = -1;
+
+            commandConnection_.setEvents(EPOLLIN);
         }
+    } else if (stallStart < 0) {
+        // socket buffer full, the rest is sent once it is writable again
+        commandStallStartMs_ = now;
+
+        commandConnection_.setEvents(EPOLLIN | EPOLLOUT);
+    }
+}
 
-        sendPacketList_.clear();
+// #################################################
+//
+Core::CommandChannelStats
+Core::getCommandChannelStats() const {
+    CommandChannelStats stats{};
+
+    stats.queueDepth = commandQueue_.depth();
+    stats.droppedPackets = commandQueue_.droppedCount();
+    stats.rejectedPackets = commandQueue_.rejectedCount();
+    stats.totalStallMs = commandStallTotalMs_;
+    stats.connected = commandConnection_.isConnected();
+    stats.connectionRetries = commandConnection_.retryCount();
+
+    int64_t stallStart = commandStallStartMs_;
 
-        sendPacketListAccess_.unlock();
+    if (stallStart >= 0) {
+        int64_t now = static_cast<int64_t>( duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(SERVER_SEND_COMMAND_RATE_MS));
+        stats.currentStallMs = now - stallStart;
     }
 
-    stopServerWriteThreadAsked_ = false;
-    serverWriteThreadStarted_ = false;
+    return stats;
 }
 
 void Core::draw_button(int posX, int posY, int width, int height) {
@@ -1338,24 +1443,24 @@ void Core::draw_command_interface(int posX, int posY) {
 
     // Direction pad
     draw_button(buttons[0].x, buttons[0].y, buttons[0].w, buttons[0].h);
-    draw_text("Up", posX + 35, posY + 10);
+    draw_label("Up", posX + 35, posY + 10);
 
     draw_button(buttons[1].x, buttons[1].y, buttons[1].w, buttons[1].h);
-    draw_text("Left", posX + 5, posY + 50);
+    draw_label("Left", posX + 5, posY + 50);
 
     draw_button(buttons[2].x, buttons[2].y, buttons[2].w, buttons[2].h);
-    draw_text("Right", posX + 55, posY + 50);
+    draw_label("Right", posX + 55, posY + 50);
 
     draw_button(buttons[3].x, buttons[3].y, buttons[3].w, buttons[3].h);
-    draw_text("Down", posX + 30, posY + 85);
+    draw_label("Down", posX + 30, posY + 85);
 
     // Button auto
     draw_button(buttons[4].x, buttons[4].y, buttons[4].w, buttons[4].h);
     draw_button(buttons[5].x, buttons[5].y, buttons[5].w, buttons[5].h);
 
     // Text
-    draw_text("Automatique", posX + 10, posY + 130);
-    draw_text("Reculer", posX + 10, posY + 170);
+    draw_label("Automatique", posX + 10, posY + 130);
+    draw_label("Reculer", posX + 10, posY + 170);
 
     // Informations
     char text_distance_a_parcourir[50];
@@ -1384,20 +1489,20 @@ void Core::draw_command_interface(int posX, int posY) {
 
     // +/- button
     draw_button(buttons[6].x, buttons[6].y, buttons[6].w, buttons[6].h);
-    draw_text("+", posX + w_button_auto + 45, posY + 100);
+    draw_label("+", posX + w_button_auto + 45, posY + 100);
     draw_button(buttons[7].x, buttons[7].y, buttons[7].w, buttons[7].h);
-    draw_text("-", posX + w_button_auto + 75 + w_button, posY + 100);
+    draw_label("-", posX + w_button_auto + 75 + w_button, posY + 100);
 
     draw_button(buttons[8].x, buttons[8].y, buttons[8].w, buttons[8].h);
-    draw_text("+", posX + w_button_auto + 45, posY + 210);
+    draw_label("+", posX + w_button_auto + 45, posY + 210);
     draw_button(buttons[9].x, buttons[9].y, buttons[9].w, buttons[9].h);
-    draw_text("-", posX + w_button_auto + 75 + w_button, posY + 210);
+    draw_label("-", posX + w_button_auto + 75 + w_button, posY + 210);
 
 //	// Text
     snprintf(text_distance_a_parcourir, sizeof(text_distance_a_parcourir), "Longeur de la rangee: %.3f",
              distance_a_parcourir);
     draw_text(text_distance_a_parcourir, posX + w_button_auto + 30, posY + 140);
-    draw_text("Distance parcourue: ", posX + w_button_auto + 30, posY + 160);
+    draw_label("Distance parcourue: ", posX + w_button_auto + 30, posY + 160);
 
     // text de la largeur de la rangée
     snprintf(text_largeur_culture, sizeof(text_largeur_culture), "Largeur de la rangee: %.3f", largeur_culture);
@@ -1409,8 +1514,8 @@ void Core::draw_command_interface(int posX, int posY) {
 //	snprintf( text_walk_distance, sizeof( text_walk_distance ), "Distance parcourue: %7.3f", distanceAuto) ;
 //	draw_text(text_walk_distance, posX + w_button_auto + 30, posY + 170);
     //tic_detection();
-    if (ha_odo_packet_ptr_ == nullptr) {
-        draw_text("no value", posX + w_button_auto + 30, posY + 170);
+    if (ha_odo_packet_.snapshot().sequence == 0) {
+        draw_label("no value", posX + w_button_auto + 30, posY + 170);
     } else {
         char vdbl1[150];
         sprintf(vdbl1, "%.3f", dist_rl);
@@ -1419,8 +1524,8 @@ void Core::draw_command_interface(int posX, int posY) {
 
     }
 
-    if (ha_odo_packet_ptr_ == nullptr) {
-        draw_text("no value", posX + w_button_auto + 30, posY + 180);
+    if (ha_odo_packet_.snapshot().sequence == 0) {
+        draw_label("no value", posX + w_button_auto + 30, posY + 180);
     } else {
         char vdbl2[150];
         sprintf(vdbl2, "%.3f", dist_rr);
@@ -1535,10 +1640,7 @@ void Core::virage(char sens) {
     }
 
     // COMMANDE MOTEUR
-    last_motor_access_.lock();
-    last_left_motor_ = static_cast<int8_t >( left * 2 );
-    last_right_motor_ = static_cast<int8_t >( right * 2 );
-    last_motor_access_.unlock();
+    setMotorSetPoint(static_cast<int8_t >( left * 2 ), static_cast<int8_t >( right * 2 ));
 }
 
 void Core::deplacement(int direction) {
@@ -1549,8 +1651,5 @@ void Core::deplacement(int direction) {
     right = 10 * direction * pid;
 
     // COMMANDE MOTEUR
-    last_motor_access_.lock();
-    last_left_motor_ = static_cast<int8_t >( left * 2 );
-    last_right_motor_ = static_cast<int8_t >( right * 2 );
-    last_motor_access_.unlock();
+    setMotorSetPoint(static_cast<int8_t >( left * 2 ), static_cast<int8_t >( right * 2 ));
 }
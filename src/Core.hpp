@@ -18,12 +18,15 @@
 #define CORE_HPP
 
 #include <iostream>
+#include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <SDL2/SDL_video.h>
 #include <SDL2/SDL_system.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <IoVecSink.hpp>
 #include <HaLidarPacket.hpp>
 #include <ApiLidarPacket.hpp>
 #include <HaOdoPacket.hpp>
@@ -31,6 +34,17 @@
 #include <ApiGpsPacket.hpp>
 #include <HaGpsPacket.hpp>
 #include <ApiStereoCameraPacket.hpp>
+#include <StereoFrameRing.hpp>
+
+#include "ConnectionOptions.hpp"
+#include "EventLoop.hpp"
+#include "LatestValue.hpp"
+#include "LidarRenderer.hpp"
+#include "ObstacleDetector.hpp"
+#include "SendQueue.hpp"
+#include "ServerConnection.hpp"
+#include "StreamingInflater.hpp"
+#include "TextRenderer.hpp"
 
 #include "ApiCodec/Naio01Codec.hpp"
 #include "ApiCodec/ApiMotorsPacket.hpp"
@@ -45,10 +59,6 @@
 
 #define RAYON 0.31
 
-#define DETECTION 50
-
-#define PAS 10
-
 
 class Core
 {
@@ -59,26 +69,80 @@ public:
 	};
 
 	const int64_t MAIN_GRAPHIC_DISPLAY_RATE_MS = 100;
-	const int64_t SERVER_SEND_COMMAND_RATE_MS = 25;
-	const int64_t WAIT_SERVER_IMAGE_TIME_RATE_MS = 10;
+	const int64_t MOTOR_KEEP_ALIVE_RATE_MS = 100;
 	const int64_t IMAGE_SERVER_WATCHDOG_SENDING_RATE_MS = 100;
-	const int64_t IMAGE_PREPARING_RATE_MS = 25;
 
 
 	const int64_t TIME_BEFORE_IMAGE_LOST_MS = 500;
+	// the server is reconnected when it sent nothing for that long
+	const int64_t SERVER_SILENCE_TIMEOUT_MS = 3000;
+
+	// frames the image codec decodes into : one being decoded, one waiting for the preparer and
+	// one being prepared. A packet gives its frame back when dropped.
+	static const size_t STEREO_FRAME_RING_SIZE = 3;
+	static const size_t STEREO_FRAME_MAX_SIZE = 752 * 480 * 3 * 2;
+
+	static const size_t COMMAND_QUEUE_CAPACITY = 64;
+
+	// read size for both servers, they share one buffer as they are read from one thread
+	static const size_t RECEIVE_BUFFER_SIZE = 4000000;
+	// one stereo pair ready to display
+	struct StereoFrame
+	{
+		ApiStereoCameraPacket::ImageType imageType;
+
+		// left then right image, 8 bits gray for raw images, RGB otherwise
+		std::vector< uint8_t > pixels;
+	};
+
 public:
 
 	Core( );
 	~Core( );
 
+	// socket tuning of the command ( 5555 ) and image ( 5557 ) channels, to set before init.
+	// Defaults are ConnectionOptions::lowLatency( ) and ConnectionOptions::highThroughput( ).
+	void setConnectionOptions( const ConnectionOptions &commandOptions, const ConnectionOptions &imageOptions );
+
 	// launch core
 	void init( std::string hostAdress_, uint16_t hostPort_ );
 
 	// thread management
 	void stop( );
-	void stopServerReadThread( );
+	struct CommandChannelStats
+	{
+		size_t queueDepth;
+		uint64_t droppedPackets;
+		uint64_t rejectedPackets;
+
+		// time spent with the socket buffer full
+		int64_t totalStallMs;
+		int64_t currentStallMs;
+		bool connected;
+		// connections refused, timed out or lost so far
+		uint64_t connectionRetries;
+	};
+
+	// callable from any thread
+	CommandChannelStats getCommandChannelStats( ) const;
+
+	struct ImageStats
+	{
+		// sequence numbers of stereo frames, the first one is 1
+		uint64_t preparedFrameSequence;
+		uint64_t displayedFrameSequence;
+
+		// prepared frames replaced by a newer one before being displayed
+		uint64_t droppedFrames;
+	};
+
+	// callable from any thread
+	ImageStats getImageStats( ) const;
+
+	void stopNetworkThread( );
+	void stopImagePreparerThread( );
 	void joinMainThread();
-	void joinServerReadThread();
+	void joinNetworkThread();
 
 	int getTime() const;
 
@@ -88,18 +152,34 @@ private:
 	// thread function
 	void graphic_thread( );
 
-	// main server 5555 thread function
-	void server_read_thread( );
-	void server_write_thread( );
+	// main server 5555 and images server 5557 event loop
+	void network_thread( );
 	void image_preparer_thread( );
 
-	// images server 5557 thread function
-	void image_server_thread( );
-	void image_server_read_thread( );
-	void image_server_write_thread( );
+	// loop thread, the command session state is sent again on each connection
+	void onServerConnected( );
+	void onServerDisconnected( );
+
+	// false once the connection is closed or broken
+	bool readAndDecode( ServerConnection &connection, Naio01Codec &codec );
+
+	// loop thread : sends the current set-point and schedules the next keep-alive
+	void sendMotorSetPoint( );
+
+	// any thread
+	void setMotorSetPoint( int8_t left, int8_t right );
+	void requestMotorSend( );
+	void requestCommandFlush( );
+
+	// event loop timers
+
+	// loop thread only, also called when the command socket is writable again
+	void flushCommandSocket( );
+	void sendImageWatchdog( );
 
 	// communications
-	void manageReceivedPacket( BaseNaio01PacketPtr packetPtr );
+	void registerPacketHandlers( );
+	void manageReceivedImage( const ApiStereoCameraPacketPtr &packetPtr );
 
 	// graph
 	SDL_Window *initSDL(const char* name, int szX, int szY );
@@ -111,10 +191,15 @@ private:
 
 	void draw_robot();
 	void draw_lidar( uint16_t lidar_distance_[271] );
-	void draw_text( char gyro_buff[100], int x, int y );
+	void draw_text( const char *text, int x, int y );
+	void draw_label( const char *text, int x, int y );
 	void draw_red_post( int x, int y );
 	void draw_images( );
 
+	// (re)creates the image textures when the frame format changes, false when SDL cannot
+	bool prepareImageTextures( Uint32 format, int width, int height );
+	void uploadImages( const StereoFrame &frame, int width, int height );
+
 	void draw_button(int posX, int posY, int width, int height);
 	void draw_command_interface(int posX, int posY);
 	void calc_info();
@@ -129,19 +214,21 @@ private:
 	bool threadStarted_;
 	std::thread graphicThread_;
 
-	bool stopServerReadThreadAsked_;
-	bool serverReadthreadStarted_;
-	std::thread serverReadThread_;
-
-	bool stopServerWriteThreadAsked_;
-	bool serverWriteThreadStarted_;
-	std::thread serverWriteThread_;
-
 	// socket part
 	std::string hostAdress_;
 	uint16_t hostPort_;
-	int socket_desc_;
-	bool socketConnected_;
+	ConnectionOptions commandConnectionOptions_;
+	ConnectionOptions imageConnectionOptions_;
+
+	EventLoop eventLoop_;
+
+	ServerConnection commandConnection_;
+	ServerConnection imageConnection_;
+
+	// replayed to the robot on reconnection
+	std::atomic< bool > videoEnabled_;
+	std::thread networkThread_;
+	std::vector< uint8_t > receiveBuffer_;
 
 	// sdl part
 	int sdlKey_[SDL_NUM_SCANCODES];
@@ -166,32 +253,49 @@ private:
 
 	// codec part
 	Naio01Codec naioCodec_;
-	std::mutex sendPacketListAccess_;
-	std::vector< BaseNaio01PacketPtr > sendPacketList_;
-
-	std::mutex ha_lidar_packet_ptr_access_;
-	HaLidarPacketPtr ha_lidar_packet_ptr_;
+	SendQueue commandQueue_;
+	IoVecSink sendSink_;
 
-	std::mutex ha_gyro_packet_ptr_access_;
-	HaGyroPacketPtr ha_gyro_packet_ptr_;
+	// -1 when the command socket takes everything we write
+	std::atomic< int64_t > commandStallStartMs_;
+	std::atomic< int64_t > commandStallTotalMs_;
 
-	std::mutex ha_accel_packet_ptr_access_;
-	HaAcceleroPacketPtr ha_accel_packet_ptr_;
+	int motorKeepAliveTimer_;
+	std::atomic< bool > motorSendPending_;
 
-	std::mutex ha_odo_packet_ptr_access;
-	HaOdoPacketPtr ha_odo_packet_ptr_;
+	// published by the network thread, read by the graphic thread
+	LatestValue< HaLidarPacketPtr > ha_lidar_packet_;
+	LatestValue< HaGyroPacketPtr > ha_gyro_packet_;
+	LatestValue< HaAcceleroPacketPtr > ha_accel_packet_;
+	LatestValue< HaOdoPacketPtr > ha_odo_packet_;
+	LatestValue< ApiPostPacketPtr > api_post_packet_;
+	LatestValue< HaGpsPacketPtr > ha_gps_packet_;
 
-	std::mutex api_post_packet_ptr_access_;
-	ApiPostPacketPtr api_post_packet_ptr_;
-
-	std::mutex ha_gps_packet_ptr_access_;
-	HaGpsPacketPtr ha_gps_packet_ptr_;
+	// run on every lidar scan by the network thread, read by the keyboard and the motor sender
+	ObstacleDetector obstacleDetector_;
 
+	// newest image not yet prepared, wakes the image preparer
 	std::mutex api_stereo_camera_packet_ptr_access_;
 	ApiStereoCameraPacketPtr api_stereo_camera_packet_ptr_;
-	std::mutex last_images_buffer_access_;
-	uint8_t last_images_buffer_[ 4000000 ];
-	ApiStereoCameraPacket::ImageType last_image_type_;
+	std::condition_variable api_stereo_camera_packet_ready_;
+	bool imagePreparerStopAsked_;
+
+	// prepared by the image preparer thread, displayed by the graphic thread
+	LatestValue< StereoFrame > stereoFrames_;
+	std::atomic< uint64_t > displayedFrameSequence_;
+
+	// streaming textures the images are uploaded into once per frame, graphic thread only
+	SDL_Texture *leftImageTexture_;
+	SDL_Texture *rightImageTexture_;
+	Uint32 imageTextureFormat_;
+	int imageTextureWidth_;
+	uint64_t uploadedFrameSequence_;
+
+	// gray images go to the Y plane of IYUV textures, with neutral U and V planes, unless the
+	// renderer refuses IYUV : they are then expanded to RGB here
+	bool grayTexturesUnsupported_;
+	std::vector< uint8_t > neutralChromaPlane_;
+	std::vector< uint8_t > grayExpansionBuffer_;
 
 	// ia part
 	ControlType controlType_;
@@ -202,6 +306,8 @@ private:
 	SDL_Color sdl_color_red_;
 	SDL_Color sdl_color_white_;
 	TTF_Font* ttf_font_;
+	TextRenderer textRenderer_;
+	LidarRenderer lidarRenderer_;
 
 	bool asked_start_video_;
 	bool asked_stop_video_;
@@ -210,27 +316,14 @@ private:
 
 	uint64_t last_motor_time_;
 
-	int image_socket_desc_;
-	bool imageSocketConnected_;
 	Naio01Codec imageNaioCodec_;
-
-	bool stopImageServerThreadAsked_;
-	bool imageServerThreadStarted_;
-	std::thread imageServerThread_;
-
-	bool stopImageServerReadThreadAsked_;
-	bool imageServerReadthreadStarted_;
-	std::thread imageServerReadThread_;
-
-	bool stopImageServerWriteThreadAsked_;
-	bool imageServerWriteThreadStarted_;
-	std::thread imageServerWriteThread_;
+	StereoFrameRing stereoFrameRing_;
+	StreamingInflater imageInflater_;
 
 	std::mutex last_motor_access_;
 	int8_t last_left_motor_;
 	int8_t last_right_motor_;
 
-	uint64_t last_image_received_time_;
 
 	std::mutex info_robot;
 	std::thread info_thread;
@@ -251,12 +344,6 @@ private:
 	double dist_fr = 0.0;
 	int zoneDetection = 0;
 	bool detectionObject = false;
-    bool detectionObject_droite = false;
-    bool detectionObject_gauche = false;
-    bool detectionObject_milieu = false;
-    int zoneDetection_gauche = 0;
-    int zoneDetection_droite = 0;
-    int zoneDetection_milieu = 0;
 
     bool dir_f = false;
     bool dir_r = false;
@@ -0,0 +1,109 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#include "DecodePool.hpp"
+
+// #################################################
+//
+DecodePool::DecodePool(size_t threadCount, size_t receiveBufferSize) :
+        receiveBufferSize_{receiveBufferSize},
+        jobsAccess_{},
+        jobsAvailable_{},
+        jobs_{},
+        stopAsked_{false},
+        threads_{} {
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&DecodePool::worker_thread, this);
+    }
+}
+
+// #################################################
+//
+DecodePool::~DecodePool() {
+    stop();
+}
+
+// #################################################
+//
+void
+DecodePool::submit(Job job) {
+    jobsAccess_.lock();
+
+    bool accepted = not stopAsked_;
+
+    if (accepted) {
+        jobs_.push_back(std::move(job));
+    }
+
+    jobsAccess_.unlock();
+
+    if (accepted) {
+        jobsAvailable_.notify_one();
+    }
+}
+
+// #################################################
+//
+void
+DecodePool::stop() {
+    jobsAccess_.lock();
+
+    stopAsked_ = true;
+
+    jobsAccess_.unlock();
+
+    jobsAvailable_.notify_all();
+
+    for (std::thread &thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+// #################################################
+//
+size_t
+DecodePool::getThreadCount() const {
+    return threads_.size();
+}
+
+// #################################################
+// thread function
+void
+DecodePool::worker_thread() {
+    // one read per job : the buffer only bounds a system call, not a packet
+    std::vector<uint8_t> receiveBuffer(receiveBufferSize_);
+
+    while (true) {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(jobsAccess_);
+
+            jobsAvailable_.wait(lock, [this]() { return stopAsked_ or not jobs_.empty(); });
+
+            if (jobs_.empty()) {
+                return;
+            }
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        job(receiveBuffer);
+    }
+}
@@ -0,0 +1,68 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef DECODE_POOL_HPP
+#define DECODE_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads reading and decoding sockets handed over by an event loop, so a few threads
+// serve the heavy streams of many robots. EPOLLONESHOT gives a connection to one job at a time,
+// it does not serialise the jobs of successive connections : a job left from a dropped
+// connection may run next to the first one of the next, so a session that reconnects still
+// guards its codec, as RobotSession does.
+class DecodePool
+{
+public:
+	// receiveBuffer belongs to the worker running the job, valid for the job only
+	typedef std::function< void( std::vector< uint8_t > &receiveBuffer ) > Job;
+
+public:
+	DecodePool( size_t threadCount, size_t receiveBufferSize );
+	~DecodePool( );
+
+	DecodePool( const DecodePool & ) = delete;
+	DecodePool &operator=( const DecodePool & ) = delete;
+
+	// callable from any thread, jobs submitted after stop( ) are dropped
+	void submit( Job job );
+
+	// runs the jobs already submitted, then joins the workers
+	void stop( );
+
+	size_t getThreadCount( ) const;
+
+private:
+	void worker_thread( );
+
+private:
+	size_t receiveBufferSize_;
+
+	std::mutex jobsAccess_;
+	std::condition_variable jobsAvailable_;
+	std::deque< Job > jobs_;
+	bool stopAsked_;
+
+	std::vector< std::thread > threads_;
+};
+
+#endif // DECODE_POOL_HPP
@@ -0,0 +1,272 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#include "EventLoop.hpp"
+
+#include <cerrno>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+    const int MAX_EVENTS_PER_WAIT = 16;
+}
+
+// #################################################
+//
+EventLoop::EventLoop() :
+        epollFd_{epoll_create1(EPOLL_CLOEXEC)},
+        wakeUpFd_{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+        stopAsked_{false},
+        loopThreadId_{std::thread::id()},
+        ioCallbacks_{},
+        timerFds_{},
+        postedTasksAccess_{},
+        postedTasks_{},
+        runningTasks_{} {
+    if (epollFd_ < 0 or wakeUpFd_ < 0) {
+        std::cout << "Could not create event loop" << std::endl;
+    }
+
+    addFd(wakeUpFd_, EPOLLIN, [this](uint32_t) {
+        uint64_t count = 0;
+
+        ssize_t readSize = read(wakeUpFd_, &count, sizeof(count));
+
+        (void) readSize;
+
+        runPostedTasks();
+    });
+}
+
+// #################################################
+//
+EventLoop::~EventLoop() {
+    // timers are owned by the loop
+    for (int timerFd : timerFds_) {
+        close(timerFd);
+    }
+
+    close(wakeUpFd_);
+    close(epollFd_);
+}
+
+// #################################################
+//
+bool
+EventLoop::addFd(int fd, uint32_t events, IoCallback callback) {
+    struct epoll_event event{};
+
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return false;
+    }
+
+    ioCallbacks_[fd] = std::make_shared<IoCallback>(std::move(callback));
+
+    return true;
+}
+
+// #################################################
+//
+bool
+EventLoop::modifyFd(int fd, uint32_t events) {
+    struct epoll_event event{};
+
+    event.events = events;
+    event.data.fd = fd;
+
+    return epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+// #################################################
+//
+void
+EventLoop::removeFd(int fd) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+
+    ioCallbacks_.erase(fd);
+}
+
+// #################################################
+//
+int
+EventLoop::addTimer(int64_t periodMs, Task callback) {
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (timerFd < 0) {
+        return -1;
+    }
+
+    if (periodMs > 0) {
+        struct itimerspec spec{};
+
+        spec.it_interval.tv_sec = static_cast<time_t>( periodMs / 1000 );
+        spec.it_interval.tv_nsec = static_cast<long>( ( periodMs % 1000 ) * 1000000 );
+        spec.it_value = spec.it_interval;
+
+        timerfd_settime(timerFd, 0, &spec, nullptr);
+    }
+
+    bool added = addFd(timerFd, EPOLLIN, [timerFd, callback](uint32_t) {
+        uint64_t expirations = 0;
+
+        // ticks missed while busy are not replayed, one call catches up
+        if (read(timerFd, &expirations, sizeof(expirations)) > 0) {
+            callback();
+        }
+    });
+
+    if (not added) {
+        close(timerFd);
+
+        return -1;
+    }
+
+    timerFds_.insert(timerFd);
+
+    return timerFd;
+}
+
+// #################################################
+//
+void
+EventLoop::removeTimer(int timerId) {
+    if (timerFds_.erase(timerId) == 0) {
+        return;
+    }
+
+    removeFd(timerId);
+
+    close(timerId);
+}
+
+// #################################################
+//
+void
+EventLoop::armTimer(int timerId, int64_t delayMs) {
+    struct itimerspec spec{};
+
+    // a zero it_value would disarm the timer
+    spec.it_value.tv_sec = static_cast<time_t>( delayMs / 1000 );
+    spec.it_value.tv_nsec = static_cast<long>( delayMs > 0 ? ( delayMs % 1000 ) * 1000000 : 1 );
+
+    timerfd_settime(timerId, 0, &spec, nullptr);
+}
+
+// #################################################
+//
+void
+EventLoop::post(Task task) {
+    postedTasksAccess_.lock();
+
+    postedTasks_.push_back(std::move(task));
+
+    postedTasksAccess_.unlock();
+
+    wakeUp();
+}
+
+// #################################################
+//
+void
+EventLoop::run() {
+    loopThreadId_ = std::this_thread::get_id();
+
+    struct epoll_event events[MAX_EVENTS_PER_WAIT];
+
+    while (not stopAsked_) {
+        int eventCount = epoll_wait(epollFd_, events, MAX_EVENTS_PER_WAIT, -1);
+
+        if (eventCount < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            std::cout << "epoll_wait failed, leaving event loop" << std::endl;
+
+            break;
+        }
+
+        for (int i = 0; i < eventCount; i++) {
+            auto found = ioCallbacks_.find(events[i].data.fd);
+
+            // removed by a callback of this same batch
+            if (found == ioCallbacks_.end()) {
+                continue;
+            }
+
+            std::shared_ptr<IoCallback> callback = found->second;
+
+            (*callback)(events[i].events);
+        }
+    }
+
+    // what was posted meanwhile may hold resources to release
+    runPostedTasks();
+
+    stopAsked_ = false;
+    loopThreadId_ = std::thread::id();
+}
+
+// #################################################
+//
+void
+EventLoop::stop() {
+    stopAsked_ = true;
+
+    wakeUp();
+}
+
+// #################################################
+//
+bool
+EventLoop::isInLoopThread() const {
+    return loopThreadId_ == std::this_thread::get_id();
+}
+
+// #################################################
+//
+void
+EventLoop::wakeUp() {
+    uint64_t one = 1;
+
+    ssize_t writeSize = write(wakeUpFd_, &one, sizeof(one));
+
+    (void) writeSize;
+}
+
+// #################################################
+//
+void
+EventLoop::runPostedTasks() {
+    postedTasksAccess_.lock();
+
+    // swapped out so tasks can post again without deadlocking, vectors keep their capacity
+    runningTasks_.swap(postedTasks_);
+
+    postedTasksAccess_.unlock();
+
+    for (auto &&task : runningTasks_) {
+        task();
+    }
+
+    runningTasks_.clear();
+}
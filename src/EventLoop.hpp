@@ -0,0 +1,90 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Single threaded reactor : sockets and timers are watched with one epoll set, their callbacks
+// all run on the thread calling run( ).
+class EventLoop
+{
+public:
+	// receives the epoll events ( EPOLLIN, EPOLLOUT, EPOLLHUP ... ) of the fd
+	typedef std::function< void( uint32_t events ) > IoCallback;
+
+	typedef std::function< void( ) > Task;
+
+public:
+	EventLoop( );
+	~EventLoop( );
+
+	EventLoop( const EventLoop & ) = delete;
+	EventLoop &operator=( const EventLoop & ) = delete;
+
+	// watches fd, the loop does not own it. Returns false if epoll refuses it.
+	bool addFd( int fd, uint32_t events, IoCallback callback );
+	bool modifyFd( int fd, uint32_t events );
+	void removeFd( int fd );
+
+	// periodic timer on the monotonic clock, first run one period from now. A periodMs of 0 gives
+	// a disarmed timer, for armTimer. Returns an id for removeTimer, -1 on failure.
+	int addTimer( int64_t periodMs, Task callback );
+	void removeTimer( int timerId );
+
+	// ( re )schedules the timer to run once, delayMs from now, replacing its period
+	void armTimer( int timerId, int64_t delayMs );
+
+	// runs task on the loop thread, callable from any thread
+	void post( Task task );
+
+	// dispatches events until stop( )
+	void run( );
+
+	// callable from any thread
+	void stop( );
+
+	bool isInLoopThread( ) const;
+
+private:
+	void wakeUp( );
+	void runPostedTasks( );
+
+private:
+	int epollFd_;
+	int wakeUpFd_;
+
+	std::atomic< bool > stopAsked_;
+	std::atomic< std::thread::id > loopThreadId_;
+
+	// shared so a callback can remove its own fd while running
+	std::unordered_map< int, std::shared_ptr< IoCallback > > ioCallbacks_;
+	std::unordered_set< int > timerFds_;
+
+	std::mutex postedTasksAccess_;
+	std::vector< Task > postedTasks_;
+	std::vector< Task > runningTasks_;
+};
+
+#endif // EVENT_LOOP_HPP
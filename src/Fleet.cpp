@@ -0,0 +1,97 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#include "Fleet.hpp"
+
+namespace {
+    size_t defaultDecodeThreadCount() {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+
+        return hardwareThreads > 2 ? hardwareThreads / 2 : 1;
+    }
+}
+
+// #################################################
+//
+Fleet::Fleet(size_t decodeThreadCount) :
+        eventLoop_{},
+        decodePool_{decodeThreadCount > 0 ? decodeThreadCount : defaultDecodeThreadCount(), RECEIVE_BUFFER_SIZE},
+        receiveBuffer_(RECEIVE_BUFFER_SIZE),
+        robots_{},
+        loopThread_{} {
+}
+
+// #################################################
+//
+Fleet::~Fleet() {
+    stop();
+}
+
+// #################################################
+//
+RobotSession &
+Fleet::addRobot(const std::string &host, uint16_t port) {
+    robots_.emplace_back(new RobotSession(eventLoop_, decodePool_, receiveBuffer_, host, port));
+
+    return *robots_.back();
+}
+
+// #################################################
+//
+void
+Fleet::start() {
+    for (std::unique_ptr<RobotSession> &robot : robots_) {
+        RobotSession *session = robot.get();
+
+        eventLoop_.post([session]() { session->open(); });
+    }
+
+    loopThread_ = std::thread([this]() { eventLoop_.run(); });
+}
+
+// #################################################
+//
+void
+Fleet::stop() {
+    if (not loopThread_.joinable()) {
+        return;
+    }
+
+    eventLoop_.stop();
+
+    loopThread_.join();
+
+    // pending jobs still read their socket, the sockets are closed once no job is left
+    decodePool_.stop();
+
+    for (std::unique_ptr<RobotSession> &robot : robots_) {
+        robot->close();
+    }
+}
+
+// #################################################
+//
+size_t
+Fleet::getRobotCount() const {
+    return robots_.size();
+}
+
+// #################################################
+//
+RobotSession &
+Fleet::getRobot(size_t index) {
+    return *robots_[index];
+}
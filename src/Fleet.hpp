@@ -0,0 +1,67 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef FLEET_HPP
+#define FLEET_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DecodePool.hpp"
+#include "EventLoop.hpp"
+#include "RobotSession.hpp"
+
+// Many robots served from one process : one event loop thread for every socket and timer, and
+// one decode pool for the image streams, whatever the number of robots.
+class Fleet
+{
+public:
+	// bounds one read system call, not a packet
+	static const size_t RECEIVE_BUFFER_SIZE = 256 * 1024;
+
+public:
+	// 0 decode threads picks half the hardware threads
+	explicit Fleet( size_t decodeThreadCount = 0 );
+	~Fleet( );
+
+	Fleet( const Fleet & ) = delete;
+	Fleet &operator=( const Fleet & ) = delete;
+
+	// before start
+	RobotSession &addRobot( const std::string &host, uint16_t port );
+
+	// connects every robot and serves them until stop( )
+	void start( );
+	void stop( );
+
+	size_t getRobotCount( ) const;
+	RobotSession &getRobot( size_t index );
+
+private:
+	EventLoop eventLoop_;
+	DecodePool decodePool_;
+
+	// loop thread only
+	std::vector< uint8_t > receiveBuffer_;
+
+	std::vector< std::unique_ptr< RobotSession > > robots_;
+
+	std::thread loopThread_;
+};
+
+#endif // FLEET_HPP
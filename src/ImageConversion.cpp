@@ -0,0 +1,135 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "ImageConversion.hpp"
+
+#if defined( __x86_64__ )
+#include <tmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __aarch64__ )
+#include <arm_neon.h>
+#endif
+
+namespace {
+    typedef void (*GrayToRgbKernel)(const uint8_t *gray, uint8_t *rgb, size_t pixelCount);
+
+    // #################################################
+    //
+    void
+    grayToRgbScalar(const uint8_t *gray, uint8_t *rgb, size_t pixelCount) {
+        for (size_t i = 0; i < pixelCount; i++) {
+            rgb[0] = gray[i];
+            rgb[1] = gray[i];
+            rgb[2] = gray[i];
+
+            rgb += 3;
+        }
+    }
+
+#if defined( __x86_64__ )
+    // #################################################
+    //
+    __attribute__(( target( "ssse3" ) ))
+    void
+    grayToRgbSsse3(const uint8_t *gray, uint8_t *rgb, size_t pixelCount) {
+        // 16 gray pixels give 48 bytes, each shuffle builds 16 of them
+        const __m128i first = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+        const __m128i second = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+        const __m128i third = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+        size_t i = 0;
+
+        for (; i + 16 <= pixelCount; i += 16) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>( gray + i ));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>( rgb ), _mm_shuffle_epi8(pixels, first));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>( rgb + 16 ), _mm_shuffle_epi8(pixels, second));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>( rgb + 32 ), _mm_shuffle_epi8(pixels, third));
+
+            rgb += 48;
+        }
+
+        grayToRgbScalar(gray + i, rgb, pixelCount - i);
+    }
+#elif defined( __ARM_NEON ) || defined( __aarch64__ )
+    // #################################################
+    //
+    void
+    grayToRgbNeon(const uint8_t *gray, uint8_t *rgb, size_t pixelCount) {
+        size_t i = 0;
+
+        for (; i + 16 <= pixelCount; i += 16) {
+            uint8x16x3_t pixels;
+
+            pixels.val[0] = vld1q_u8(gray + i);
+            pixels.val[1] = pixels.val[0];
+            pixels.val[2] = pixels.val[0];
+
+            // interleaving store, writes the 48 bytes at once
+            vst3q_u8(rgb, pixels);
+
+            rgb += 48;
+        }
+
+        grayToRgbScalar(gray + i, rgb, pixelCount - i);
+    }
+#endif
+
+    struct GrayToRgbDispatch {
+        GrayToRgbKernel kernel;
+        const char *name;
+
+        GrayToRgbDispatch() :
+                kernel{grayToRgbScalar},
+                name{"scalar"} {
+#if defined( __x86_64__ )
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("ssse3")) {
+                kernel = grayToRgbSsse3;
+                name = "ssse3";
+            }
+#elif defined( __ARM_NEON ) || defined( __aarch64__ )
+            // built for a cpu that has it
+            kernel = grayToRgbNeon;
+            name = "neon";
+#endif
+        }
+    };
+
+    // #################################################
+    //
+    const GrayToRgbDispatch &
+    dispatch() {
+        static const GrayToRgbDispatch instance;
+
+        return instance;
+    }
+}
+
+// #################################################
+//
+void
+grayToRgb(const uint8_t *gray, uint8_t *rgb, size_t pixelCount) {
+    dispatch().kernel(gray, rgb, pixelCount);
+}
+
+// #################################################
+//
+const char *
+grayToRgbKernelName() {
+    return dispatch().name;
+}
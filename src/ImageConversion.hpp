@@ -0,0 +1,31 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef IMAGE_CONVERSION_HPP
+#define IMAGE_CONVERSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Expands pixelCount 8 bits gray pixels into RGB24 pixels, the 3 channels being equal. Picks
+// SSSE3 or NEON when the cpu has it, a scalar loop otherwise.
+void grayToRgb(const uint8_t *gray, uint8_t *rgb, size_t pixelCount);
+
+// kernel picked by grayToRgb, for logs
+const char *grayToRgbKernelName();
+
+#endif // IMAGE_CONVERSION_HPP
@@ -0,0 +1,133 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef LATEST_VALUE_HPP
+#define LATEST_VALUE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Last value published by one producer thread, read by one consumer thread, both wait-free :
+// a triple buffer, the producer writes a slot the consumer never reads and swaps it with the
+// shared middle slot, the consumer swaps that one with its own when it is newer.
+template< typename T >
+class LatestValue
+{
+public:
+	struct Snapshot
+	{
+		T value;
+
+		// 0 until the first publish, then 1, 2, ... skipped values show as gaps
+		uint64_t sequence;
+
+		// steady clock
+		int64_t receivedAtMs;
+	};
+
+public:
+	LatestValue( ) :
+		slots_{ },
+		middle_{ 1 },
+		backIndex_{ 0 },
+		sequence_{ 0 },
+		droppedCount_{ 0 },
+		frontIndex_{ 2 }
+	{
+	}
+
+	LatestValue( const LatestValue & ) = delete;
+	LatestValue &operator=( const LatestValue & ) = delete;
+
+	// producer thread
+	void publish( T value )
+	{
+		back() = std::move( value );
+
+		publishBack();
+	}
+
+	// producer thread : the value publishBack( ) publishes next, to be filled in place. It holds
+	// some older value, so big values are recycled instead of reallocated.
+	T &back( )
+	{
+		return slots_[ backIndex_ ].value;
+	}
+
+	void publishBack( )
+	{
+		Snapshot &slot = slots_[ backIndex_ ];
+
+		slot.sequence = sequence_.fetch_add( 1, std::memory_order_relaxed ) + 1;
+		slot.receivedAtMs = static_cast< int64_t >( std::chrono::duration_cast< std::chrono::milliseconds >(
+				std::chrono::steady_clock::now().time_since_epoch() ).count() );
+
+		uint8_t previous = middle_.exchange( static_cast< uint8_t >( backIndex_ | FRESH ), std::memory_order_acq_rel );
+
+		// the consumer never took the value we just replaced
+		if( previous & FRESH )
+		{
+			droppedCount_.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		backIndex_ = previous & INDEX;
+	}
+
+	// consumer thread : the newest value, which stays untouched until the next snapshot( ) call
+	const Snapshot &snapshot( )
+	{
+		if( middle_.load( std::memory_order_relaxed ) & FRESH )
+		{
+			frontIndex_ = middle_.exchange( frontIndex_, std::memory_order_acq_rel ) & INDEX;
+		}
+
+		return slots_[ frontIndex_ ];
+	}
+
+	// any thread : sequence of the last published value
+	uint64_t publishedCount( ) const
+	{
+		return sequence_.load( std::memory_order_relaxed );
+	}
+
+	// any thread : values replaced before the consumer took them
+	uint64_t droppedCount( ) const
+	{
+		return droppedCount_.load( std::memory_order_relaxed );
+	}
+
+private:
+	static const uint8_t INDEX = 0x03;
+
+	// the middle slot holds a value the consumer has not taken yet
+	static const uint8_t FRESH = 0x04;
+
+	std::array< Snapshot, 3 > slots_;
+
+	std::atomic< uint8_t > middle_;
+
+	// producer thread only
+	uint8_t backIndex_;
+	std::atomic< uint64_t > sequence_;
+	std::atomic< uint64_t > droppedCount_;
+
+	// consumer thread only
+	uint8_t frontIndex_;
+};
+
+#endif // LATEST_VALUE_HPP
@@ -0,0 +1,126 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "LidarRenderer.hpp"
+
+#include <cmath>
+
+const uint16_t LidarRenderer::MIN_DISTANCE;
+
+namespace {
+    // beam angles are multiples of the step, a rounding error must not move a beam out of a sector
+    const float ANGLE_TOLERANCE_DEG = 0.001f;
+}
+
+// #################################################
+//
+LidarRenderer::LidarRenderer(size_t beamCount, float firstBeamAngleDeg, float beamStepDeg) :
+        beamCount_{beamCount},
+        firstBeamAngleDeg_{firstBeamAngleDeg},
+        beamStepDeg_{beamStepDeg},
+        originX_{0.0f},
+        originY_{0.0f},
+        pixelsPerUnit_{1.0f},
+        firstDrawnBeam_{0},
+        endDrawnBeam_{beamCount},
+        cos_(beamCount),
+        sin_(beamCount),
+        x_(beamCount),
+        y_(beamCount),
+        points_{} {
+    for (size_t i = 0; i < beamCount_; i++) {
+        double angle = static_cast<double>( firstBeamAngleDeg_ + static_cast<float>( i ) * beamStepDeg_ ) * M_PI / 180.0;
+
+        cos_[i] = static_cast<float>( std::cos(angle));
+        sin_[i] = static_cast<float>( std::sin(angle));
+    }
+
+    points_.reserve(beamCount_);
+}
+
+// #################################################
+//
+void
+LidarRenderer::setView(int originX, int originY, float pixelsPerUnit) {
+    originX_ = static_cast<float>( originX );
+    originY_ = static_cast<float>( originY );
+    pixelsPerUnit_ = pixelsPerUnit;
+}
+
+// #################################################
+//
+void
+LidarRenderer::setDrawnSector(float fromDeg, float toDeg) {
+    firstDrawnBeam_ = beamCount_;
+    endDrawnBeam_ = 0;
+
+    for (size_t i = 0; i < beamCount_; i++) {
+        float angle = firstBeamAngleDeg_ + static_cast<float>( i ) * beamStepDeg_;
+
+        if (angle > fromDeg + ANGLE_TOLERANCE_DEG and angle <= toDeg + ANGLE_TOLERANCE_DEG) {
+            if (i < firstDrawnBeam_) {
+                firstDrawnBeam_ = i;
+            }
+
+            endDrawnBeam_ = i + 1;
+        }
+    }
+
+    if (firstDrawnBeam_ > endDrawnBeam_) {
+        firstDrawnBeam_ = endDrawnBeam_;
+    }
+}
+
+// #################################################
+//
+void
+LidarRenderer::draw(SDL_Renderer *renderer, const uint16_t *distances) {
+    size_t count = endDrawnBeam_ - firstDrawnBeam_;
+
+    const uint16_t *beamDistances = distances + firstDrawnBeam_;
+    const float *beamCos = cos_.data() + firstDrawnBeam_;
+    const float *beamSin = sin_.data() + firstDrawnBeam_;
+
+    float *x = x_.data();
+    float *y = y_.data();
+
+    // no branch and separate arrays, so that the compiler vectorizes the conversion
+    for (size_t i = 0; i < count; i++) {
+        float distance = static_cast<float>( beamDistances[i] ) * pixelsPerUnit_;
+
+        x[i] = originX_ - distance * beamCos[i];
+        y[i] = originY_ - distance * beamSin[i];
+    }
+
+    points_.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        if (beamDistances[i] >= MIN_DISTANCE) {
+            points_.push_back({static_cast<int>( x[i] ), static_cast<int>( y[i] )});
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDrawPoints(renderer, points_.data(), static_cast<int>( points_.size()));
+}
+
+// #################################################
+//
+size_t
+LidarRenderer::getBeamCount() const {
+    return beamCount_;
+}
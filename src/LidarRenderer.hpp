@@ -0,0 +1,73 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef LIDAR_RENDERER_HPP
+#define LIDAR_RENDERER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+
+// Draws lidar scans as one batch of points. The cosine and sine of every beam are computed once,
+// from the beam count and angles given at construction, so a lidar with more beams only needs
+// other constructor arguments.
+class LidarRenderer
+{
+public:
+	// closer returns are lidar noise, they are not drawn
+	static const uint16_t MIN_DISTANCE = 30;
+
+public:
+	// beam i points at firstBeamAngleDeg + i * beamStepDeg, 0 being the left of the robot
+	LidarRenderer( size_t beamCount, float firstBeamAngleDeg, float beamStepDeg );
+
+	// where the lidar is on screen, and how many pixels a distance unit takes
+	void setView( int originX, int originY, float pixelsPerUnit );
+
+	// only beams pointing in ( fromDeg, toDeg ] are drawn
+	void setDrawnSector( float fromDeg, float toDeg );
+
+	// distances holds one value per beam
+	void draw( SDL_Renderer *renderer, const uint16_t *distances );
+
+	size_t getBeamCount( ) const;
+
+private:
+	size_t beamCount_;
+	float firstBeamAngleDeg_;
+	float beamStepDeg_;
+
+	float originX_;
+	float originY_;
+	float pixelsPerUnit_;
+
+	// drawn beams are [ firstDrawnBeam_, endDrawnBeam_ )
+	size_t firstDrawnBeam_;
+	size_t endDrawnBeam_;
+
+	// per beam, filled once
+	std::vector< float > cos_;
+	std::vector< float > sin_;
+
+	// per scan, kept to not allocate each frame
+	std::vector< float > x_;
+	std::vector< float > y_;
+	std::vector< SDL_Point > points_;
+};
+
+#endif // LIDAR_RENDERER_HPP
@@ -0,0 +1,76 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "ObstacleDetector.hpp"
+
+const size_t ObstacleDetector::BEAM_COUNT;
+const size_t ObstacleDetector::FIRST_BEAM;
+const size_t ObstacleDetector::WINDOW_BEAMS;
+const size_t ObstacleDetector::WINDOWS_PER_ZONE;
+const uint32_t ObstacleDetector::DETECTION_DISTANCE;
+const uint16_t ObstacleDetector::MIN_DISTANCE;
+const uint16_t ObstacleDetector::NO_ECHO_DISTANCE;
+
+static_assert(ObstacleDetector::FIRST_BEAM + 3 * ObstacleDetector::WINDOWS_PER_ZONE * ObstacleDetector::WINDOW_BEAMS <=
+              ObstacleDetector::BEAM_COUNT, "detection windows beyond the scan");
+
+// #################################################
+//
+ObstacleDetector::ObstacleDetector() :
+        detection_{0} {
+}
+
+// #################################################
+//
+bool
+ObstacleDetector::processScan(const uint16_t *distances, int64_t scanTimeMs) {
+    uint64_t zones = 0;
+
+    for (size_t window = 0; window < 3 * WINDOWS_PER_ZONE; window++) {
+        const uint16_t *beams = distances + FIRST_BEAM + (window * WINDOW_BEAMS);
+
+        uint32_t sum = 0;
+
+        // fixed length and a select instead of a branch, the compiler makes vector adds of it
+        for (size_t i = 0; i < WINDOW_BEAMS; i++) {
+            uint32_t distance = beams[i];
+
+            sum += (distance < MIN_DISTANCE) ? NO_ECHO_DISTANCE : distance;
+        }
+
+        if (sum < DETECTION_DISTANCE * WINDOW_BEAMS) {
+            // zones are numbered from the left, as their bits
+            zones |= uint64_t{1} << (window / WINDOWS_PER_ZONE);
+        }
+    }
+
+    uint64_t previous = detection_.exchange((static_cast<uint64_t>( scanTimeMs ) << 8) | zones);
+
+    return (previous & ZONE_MASK) != zones;
+}
+
+// #################################################
+//
+ObstacleDetector::Detection
+ObstacleDetector::getDetection() const {
+    uint64_t detection = detection_.load();
+
+    return Detection{(detection & ZONE_LEFT) != 0,
+                     (detection & ZONE_MIDDLE) != 0,
+                     (detection & ZONE_RIGHT) != 0,
+                     static_cast<int64_t>( detection >> 8 )};
+}
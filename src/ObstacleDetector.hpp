@@ -0,0 +1,82 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef OBSTACLE_DETECTOR_HPP
+#define OBSTACLE_DETECTOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Looks for obstacles in front of the robot on every lidar scan, from the thread decoding them.
+// The beams from the left to the right of the robot are cut in windows of WINDOW_BEAMS beams,
+// grouped in three zones : a window closer than DETECTION_DISTANCE on average blocks its zone.
+// The result of the last scan is published as a single atomic word, readable from any thread.
+class ObstacleDetector
+{
+public:
+	static const size_t BEAM_COUNT = 271;
+
+	static const size_t FIRST_BEAM = 81;
+	static const size_t WINDOW_BEAMS = 10;
+	static const size_t WINDOWS_PER_ZONE = 4;
+
+	// lidar units ( mm )
+	static const uint32_t DETECTION_DISTANCE = 500;
+
+	// closer returns are lidar noise, they count as nothing in sight
+	static const uint16_t MIN_DISTANCE = 30;
+	static const uint16_t NO_ECHO_DISTANCE = 50000;
+
+	struct Detection
+	{
+		bool left;
+		bool middle;
+		bool right;
+
+		// steady clock time of the scan, 0 before the first one
+		int64_t scanTimeMs;
+
+		bool any( ) const
+		{
+			return left or middle or right;
+		}
+	};
+
+public:
+	ObstacleDetector( );
+
+	// distances holds BEAM_COUNT values, true when the blocked zones changed with this scan
+	bool processScan( const uint16_t *distances, int64_t scanTimeMs );
+
+	// any thread
+	Detection getDetection( ) const;
+
+private:
+	enum Zone : uint64_t
+	{
+		ZONE_LEFT = 0x1,
+		ZONE_MIDDLE = 0x2,
+		ZONE_RIGHT = 0x4,
+		ZONE_MASK = 0x7
+	};
+
+	// scan time shifted left by 8, zones in the low byte
+	std::atomic< uint64_t > detection_;
+};
+
+#endif // OBSTACLE_DETECTOR_HPP
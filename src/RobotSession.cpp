@@ -0,0 +1,457 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#include "RobotSession.hpp"
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <ApiCommandPacket.hpp>
+#include <ApiMotorsPacket.hpp>
+#include <ApiWatchdogPacket.hpp>
+#include <HaMotorsPacket.hpp>
+
+namespace {
+    uint16_t packSetPoint(int8_t left, int8_t right) {
+        return static_cast<uint16_t>( ( static_cast<uint8_t>( left ) << 8 ) | static_cast<uint8_t>( right ));
+    }
+}
+
+// #################################################
+//
+RobotSession::RobotSession(EventLoop &eventLoop, DecodePool &decodePool, std::vector<uint8_t> &receiveBuffer,
+                           std::string host, uint16_t port) :
+        eventLoop_(eventLoop),
+        decodePool_(decodePool),
+        receiveBuffer_(receiveBuffer),
+        host_{std::move(host)},
+        port_{port},
+        name_{host_ + ":" + std::to_string(static_cast<unsigned>( port_ ))},
+        commandConnection_{eventLoop_, name_},
+        imageConnection_{eventLoop_, name_ + " image"},
+        naioCodec_{},
+        imageNaioCodec_{},
+        imageHandler_{},
+        imageDecodeAccess_{},
+        decodedSocket_{nullptr},
+        commandQueue_{COMMAND_QUEUE_CAPACITY},
+        sendSink_{},
+        commandStalled_{false},
+        motorKeepAliveTimer_{-1},
+        watchdogTimer_{-1},
+        motorSetPoint_{0},
+        motorSendPending_{false},
+        videoEnabled_{false},
+        imageConnectionOpened_{false},
+        packetsReceived_{0},
+        imagesReceived_{0},
+        sensorAccess_{},
+        ha_lidar_packet_ptr_{nullptr},
+        ha_odo_packet_ptr_{nullptr},
+        ha_gps_packet_ptr_{nullptr} {
+    naioCodec_.enablePacketPool();
+
+    registerPacketHandlers();
+
+    motorKeepAliveTimer_ = eventLoop_.addTimer(0, [this]() { sendMotorSetPoint(); });
+    watchdogTimer_ = eventLoop_.addTimer(0, [this]() { sendImageWatchdog(); });
+
+    commandConnection_.setCallbacks([this](int) { onServerConnected(); },
+                                    [this](uint32_t events) { onServerEvents(events); },
+                                    [this]() { onServerDisconnected(); });
+
+    // the robot streams its sensors, a silent server is a dead link
+    commandConnection_.setSilenceTimeout(SERVER_SILENCE_TIMEOUT_MS);
+
+    // pool threads read through the shared socket, which the connection invalidates before
+    // closing it : a reconnection never hands them the descriptor of the next connection
+    imageConnection_.setCallbacks([this](int) {
+        // one pool job at a time per socket, rearmed once the job is over
+        imageConnection_.setEvents(EPOLLIN | EPOLLONESHOT);
+
+        sendImageWatchdog();
+    }, [this](uint32_t) {
+        SharedSocketPtr socket = imageConnection_.sharedSocket();
+
+        decodePool_.submit([this, socket](std::vector<uint8_t> &workerBuffer) {
+            decodeImages(socket, workerBuffer);
+        });
+    }, nullptr);
+}
+
+// #################################################
+//
+RobotSession::~RobotSession() {
+    eventLoop_.removeTimer(motorKeepAliveTimer_);
+    eventLoop_.removeTimer(watchdogTimer_);
+}
+
+// #################################################
+//
+void
+RobotSession::setImageHandler(ImageHandler handler) {
+    imageHandler_ = std::move(handler);
+}
+
+// #################################################
+//
+void
+RobotSession::open() {
+    commandConnection_.open(host_, port_, ConnectionOptions::lowLatency());
+
+    if (videoEnabled_) {
+        applyVideoEnabled(true);
+    }
+}
+
+// #################################################
+//
+void
+RobotSession::close() {
+    commandConnection_.close();
+    imageConnection_.close();
+
+    imageConnectionOpened_ = false;
+}
+
+// #################################################
+// any thread : the set-point goes out now instead of at the next keep-alive
+void
+RobotSession::setMotorSetPoint(int8_t left, int8_t right) {
+    uint16_t setPoint = packSetPoint(left, right);
+
+    if (motorSetPoint_.exchange(setPoint) != setPoint and not motorSendPending_.exchange(true)) {
+        eventLoop_.post([this]() { sendMotorSetPoint(); });
+    }
+}
+
+// #################################################
+// any thread
+void
+RobotSession::setVideoEnabled(bool enabled) {
+    if (videoEnabled_.exchange(enabled) != enabled) {
+        eventLoop_.post([this, enabled]() { applyVideoEnabled(enabled); });
+    }
+}
+
+// #################################################
+//
+RobotSession::Status
+RobotSession::getStatus() const {
+    Status status{};
+
+    status.connected = commandConnection_.isConnected();
+    status.imageConnected = imageConnection_.isConnected();
+    status.videoEnabled = videoEnabled_;
+    status.packetsReceived = packetsReceived_;
+    status.imagesReceived = imagesReceived_;
+    status.connectionRetries = commandConnection_.retryCount() + imageConnection_.retryCount();
+
+    return status;
+}
+
+// #################################################
+//
+const std::string &
+RobotSession::getName() const {
+    return name_;
+}
+
+// #################################################
+//
+HaLidarPacketPtr
+RobotSession::getLatestLidar() {
+    sensorAccess_.lock();
+
+    HaLidarPacketPtr packetPtr = ha_lidar_packet_ptr_;
+
+    sensorAccess_.unlock();
+
+    return packetPtr;
+}
+
+// #################################################
+//
+HaOdoPacketPtr
+RobotSession::getLatestOdo() {
+    sensorAccess_.lock();
+
+    HaOdoPacketPtr packetPtr = ha_odo_packet_ptr_;
+
+    sensorAccess_.unlock();
+
+    return packetPtr;
+}
+
+// #################################################
+//
+HaGpsPacketPtr
+RobotSession::getLatestGps() {
+    sensorAccess_.lock();
+
+    HaGpsPacketPtr packetPtr = ha_gps_packet_ptr_;
+
+    sensorAccess_.unlock();
+
+    return packetPtr;
+}
+
+// #################################################
+//
+void
+RobotSession::registerPacketHandlers() {
+    naioCodec_.onPacket<HaLidarPacket>([this](const HaLidarPacketPtr &packetPtr) {
+        sensorAccess_.lock();
+        ha_lidar_packet_ptr_ = packetPtr;
+        sensorAccess_.unlock();
+    });
+
+    naioCodec_.onPacket<HaOdoPacket>([this](const HaOdoPacketPtr &packetPtr) {
+        sensorAccess_.lock();
+        ha_odo_packet_ptr_ = packetPtr;
+        sensorAccess_.unlock();
+    });
+
+    naioCodec_.onPacket<HaGpsPacket>([this](const HaGpsPacketPtr &packetPtr) {
+        sensorAccess_.lock();
+        ha_gps_packet_ptr_ = packetPtr;
+        sensorAccess_.unlock();
+    });
+
+    imageNaioCodec_.onPacket<ApiStereoCameraPacket>([this](const ApiStereoCameraPacketPtr &packetPtr) {
+        imagesReceived_++;
+
+        if (imageHandler_) {
+            imageHandler_(packetPtr);
+        }
+    });
+}
+
+// #################################################
+// a new connection starts a new session : the robot knows nothing of the previous one
+void
+RobotSession::onServerConnected() {
+    naioCodec_.reset();
+
+    // one stop frame is enough on TCP, the keep-alive repeats the set-point from there
+    ApiMotorsPacketPtr first_packet = std::make_shared<ApiMotorsPacket>(0, 0);
+    first_packet->encodeTo(sendSink_);
+
+    if (videoEnabled_) {
+        pushVideoCommands(true);
+    }
+
+    flushCommandSocket();
+
+    sendMotorSetPoint();
+}
+
+// #################################################
+//
+void
+RobotSession::onServerDisconnected() {
+    // half sent packets are meaningless on the next connection
+    sendSink_.clear();
+
+    commandStalled_ = false;
+}
+
+// #################################################
+//
+void
+RobotSession::onServerEvents(uint32_t events) {
+    if (events & EPOLLOUT) {
+        flushCommandSocket();
+    }
+
+    if ((events & ~static_cast<uint32_t>( EPOLLOUT )) == 0 or not commandConnection_.isConnected()) {
+        return;
+    }
+
+    // sensor traffic is light, it is decoded right on the loop thread
+    ssize_t readSize = read(commandConnection_.socketDesc(), receiveBuffer_.data(), receiveBuffer_.size());
+
+    if (readSize > 0) {
+        rearmQuickAck(commandConnection_.socketDesc(), commandConnection_.options());
+
+        commandConnection_.markAlive();
+
+        bool packetHeaderDetected = false;
+
+        naioCodec_.decode(receiveBuffer_.data(), static_cast<uint>( readSize ), packetHeaderDetected);
+
+        naioCodec_.currentBasePacketList.clear();
+
+        packetsReceived_ = naioCodec_.getDecoderStats().packetsDecoded;
+    } else if (readSize == 0 or (errno != EAGAIN and errno != EINTR)) {
+        commandConnection_.reconnect("read error");
+    }
+}
+
+// #################################################
+//
+void
+RobotSession::decodeImages(const SharedSocketPtr &socket, std::vector<uint8_t> &receiveBuffer) {
+    imageDecodeAccess_.lock();
+
+    ssize_t readSize = socket->read(receiveBuffer.data(), receiveBuffer.size());
+
+    bool received = readSize > 0;
+    bool alive = received or (readSize < 0 and (errno == EAGAIN or errno == EINTR));
+
+    if (received) {
+        // a new connection starts a new stream
+        if (decodedSocket_ != socket) {
+            imageNaioCodec_.reset();
+
+            decodedSocket_ = socket;
+        }
+
+        bool packetHeaderDetected = false;
+
+        imageNaioCodec_.decode(receiveBuffer.data(), static_cast<uint>( readSize ), packetHeaderDetected);
+
+        imageNaioCodec_.currentBasePacketList.clear();
+    }
+
+    imageDecodeAccess_.unlock();
+
+    eventLoop_.post([this, socket, received, alive]() {
+        // the connection was dropped meanwhile
+        if (imageConnection_.sharedSocket() != socket) {
+            return;
+        }
+
+        if (received) {
+            imageConnection_.markAlive();
+        }
+
+        if (alive) {
+            imageConnection_.setEvents(EPOLLIN | EPOLLONESHOT);
+        } else {
+            imageConnection_.reconnect("read error");
+        }
+    });
+}
+
+// #################################################
+// loop thread
+void
+RobotSession::applyVideoEnabled(bool enabled) {
+    // the robot only streams images while asked to, a silent image server is a dead link then
+    imageConnection_.setSilenceTimeout(enabled ? SERVER_SILENCE_TIMEOUT_MS : 0);
+
+    // the image connection stays open once opened, see the constructor
+    if (enabled and not imageConnectionOpened_) {
+        imageConnection_.open(host_, static_cast<uint16_t>( port_ + 2 ), ConnectionOptions::highThroughput());
+
+        imageConnectionOpened_ = true;
+    }
+
+    if (commandConnection_.isConnected()) {
+        pushVideoCommands(enabled);
+
+        flushCommandSocket();
+    }
+}
+
+// #################################################
+//
+void
+RobotSession::pushVideoCommands(bool enabled) {
+    if (enabled) {
+        commandQueue_.push(std::make_shared<ApiCommandPacket>(
+                ApiCommandPacket::CommandType::TURN_OFF_IMAGE_ZLIB_COMPRESSION), SendPolicy::NEVER_DROP);
+        commandQueue_.push(std::make_shared<ApiCommandPacket>(
+                ApiCommandPacket::CommandType::TURN_ON_API_RAW_STEREO_CAMERA_PACKET), SendPolicy::NEVER_DROP);
+    } else {
+        commandQueue_.push(std::make_shared<ApiCommandPacket>(
+                ApiCommandPacket::CommandType::TURN_OFF_API_RAW_STEREO_CAMERA_PACKET), SendPolicy::NEVER_DROP);
+    }
+}
+
+// #################################################
+//
+void
+RobotSession::sendMotorSetPoint() {
+    motorSendPending_ = false;
+
+    uint16_t setPoint = motorSetPoint_;
+
+    HaMotorsPacketPtr haMotorsPacketPtr = std::make_shared<HaMotorsPacket>(static_cast<int8_t>( setPoint >> 8 ),
+                                                                           static_cast<int8_t>( setPoint & 0xFF ));
+
+    // a set-point still waiting for a stalled link is replaced by this one
+    commandQueue_.push(haMotorsPacketPtr, SendPolicy::DROP_OLDEST);
+
+    flushCommandSocket();
+
+    // the next connection starts the keep-alive again
+    if (commandConnection_.isConnected()) {
+        eventLoop_.armTimer(motorKeepAliveTimer_, MOTOR_KEEP_ALIVE_RATE_MS);
+    }
+}
+
+// #################################################
+//
+void
+RobotSession::sendImageWatchdog() {
+    if (not imageConnection_.isConnected()) {
+        return;
+    }
+
+    ApiWatchdogPacketPtr api_watchdog_packet_ptr = std::make_shared<ApiWatchdogPacket>(42);
+
+    cl_copy::BufferUPtr buffer = api_watchdog_packet_ptr->encode();
+
+    // a broken link is seen by the read side, it must not raise SIGPIPE here
+    ssize_t sentSize = send(imageConnection_.socketDesc(), buffer->data(), buffer->size(), MSG_NOSIGNAL);
+
+    (void) sentSize;
+
+    eventLoop_.armTimer(watchdogTimer_, IMAGE_SERVER_WATCHDOG_SENDING_RATE_MS);
+}
+
+// #################################################
+// the whole queue goes out in one system call, never blocking the loop
+void
+RobotSession::flushCommandSocket() {
+    if (not commandConnection_.isConnected()) {
+        return;
+    }
+
+    if (sendSink_.empty()) {
+        commandQueue_.drainTo(sendSink_);
+    }
+
+    if (sendSink_.empty()) {
+        return;
+    }
+
+    if (not sendSink_.flush(commandConnection_.socketDesc())) {
+        commandConnection_.reconnect("send error");
+
+        return;
+    }
+
+    // socket buffer full, the rest is sent once it is writable again
+    if (sendSink_.empty() == commandStalled_) {
+        commandStalled_ = not sendSink_.empty();
+
+        commandConnection_.setEvents(commandStalled_ ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    }
+}
@@ -0,0 +1,150 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef ROBOT_SESSION_HPP
+#define ROBOT_SESSION_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <IoVecSink.hpp>
+#include <HaLidarPacket.hpp>
+#include <HaOdoPacket.hpp>
+#include <HaGpsPacket.hpp>
+#include <ApiStereoCameraPacket.hpp>
+#include "ApiCodec/Naio01Codec.hpp"
+#include "DecodePool.hpp"
+#include "EventLoop.hpp"
+#include "SendQueue.hpp"
+#include "ServerConnection.hpp"
+
+// Headless connection to one robot, for the fleet mode : everything runs on a shared event loop
+// and the image stream is decoded by a shared decode pool. Nothing is allocated for the image
+// channel until video is asked for.
+class RobotSession
+{
+public:
+	struct Status
+	{
+		bool connected;
+		bool imageConnected;
+		bool videoEnabled;
+		uint64_t packetsReceived;
+		uint64_t imagesReceived;
+		// connections refused, timed out or lost so far, both channels
+		uint64_t connectionRetries;
+	};
+
+	// called on a decode pool thread
+	typedef std::function< void( const ApiStereoCameraPacketPtr & ) > ImageHandler;
+
+	const int64_t MOTOR_KEEP_ALIVE_RATE_MS = 100;
+	const int64_t IMAGE_SERVER_WATCHDOG_SENDING_RATE_MS = 100;
+	const int64_t SERVER_SILENCE_TIMEOUT_MS = 3000;
+	static const size_t COMMAND_QUEUE_CAPACITY = 64;
+
+public:
+	// receiveBuffer is shared by the sessions of the loop, it is only used on the loop thread
+	RobotSession( EventLoop &eventLoop, DecodePool &decodePool, std::vector< uint8_t > &receiveBuffer,
+			std::string host, uint16_t port );
+	~RobotSession( );
+
+	RobotSession( const RobotSession & ) = delete;
+	RobotSession &operator=( const RobotSession & ) = delete;
+
+	// to set before open
+	void setImageHandler( ImageHandler handler );
+
+	// loop thread
+	void open( );
+	void close( );
+
+	// any thread
+	void setMotorSetPoint( int8_t left, int8_t right );
+	void setVideoEnabled( bool enabled );
+
+	Status getStatus( ) const;
+	const std::string &getName( ) const;
+
+	HaLidarPacketPtr getLatestLidar( );
+	HaOdoPacketPtr getLatestOdo( );
+	HaGpsPacketPtr getLatestGps( );
+
+private:
+	void registerPacketHandlers( );
+
+	void onServerConnected( );
+	void onServerDisconnected( );
+	void onServerEvents( uint32_t events );
+
+	// decode pool thread, the socket is not watched until the loop thread hears back
+	void decodeImages( const SharedSocketPtr &socket, std::vector< uint8_t > &receiveBuffer );
+
+	void applyVideoEnabled( bool enabled );
+	void pushVideoCommands( bool enabled );
+
+	void sendMotorSetPoint( );
+	void sendImageWatchdog( );
+	void flushCommandSocket( );
+
+private:
+	EventLoop &eventLoop_;
+	DecodePool &decodePool_;
+	std::vector< uint8_t > &receiveBuffer_;
+
+	std::string host_;
+	uint16_t port_;
+	std::string name_;
+
+	ServerConnection commandConnection_;
+	ServerConnection imageConnection_;
+
+	Naio01Codec naioCodec_;
+	Naio01Codec imageNaioCodec_;
+	ImageHandler imageHandler_;
+
+	// a job left from a dropped connection may still run next to the first one of the new connection
+	std::mutex imageDecodeAccess_;
+	// connection the image codec state belongs to
+	SharedSocketPtr decodedSocket_;
+
+	SendQueue commandQueue_;
+	IoVecSink sendSink_;
+	bool commandStalled_;
+
+	int motorKeepAliveTimer_;
+	int watchdogTimer_;
+
+	// left in the high byte
+	std::atomic< uint16_t > motorSetPoint_;
+	std::atomic< bool > motorSendPending_;
+
+	std::atomic< bool > videoEnabled_;
+	bool imageConnectionOpened_;
+
+	std::atomic< uint64_t > packetsReceived_;
+	std::atomic< uint64_t > imagesReceived_;
+
+	std::mutex sensorAccess_;
+	HaLidarPacketPtr ha_lidar_packet_ptr_;
+	HaOdoPacketPtr ha_odo_packet_ptr_;
+	HaGpsPacketPtr ha_gps_packet_ptr_;
+};
+
+#endif // ROBOT_SESSION_HPP
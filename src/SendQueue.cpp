@@ -0,0 +1,177 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "SendQueue.hpp"
+
+// #################################################
+//
+SendQueue::SendQueue(size_t capacity) :
+        cells_{},
+        mask_{0},
+        enqueuePos_{0},
+        enqueuePosPadding_{},
+        dequeuePos_{0},
+        latest_{},
+        latestCount_{0},
+        droppedCount_{0},
+        rejectedCount_{0} {
+    size_t size = 2;
+
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+
+    for (size_t i = 0; i < size; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    for (auto &&box : latest_) {
+        box.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// #################################################
+//
+SendQueue::~SendQueue() {
+    for (auto &&box : latest_) {
+        delete box.load();
+    }
+}
+
+// #################################################
+//
+bool
+SendQueue::push(BaseNaio01PacketPtr packet, SendPolicy policy) {
+    if (policy == SendPolicy::DROP_OLDEST) {
+        BaseNaio01PacketPtr *boxed = new BaseNaio01PacketPtr(packet);
+
+        BaseNaio01PacketPtr *replaced = latest_[packet->getPacketId()].exchange(boxed, std::memory_order_acq_rel);
+
+        if (replaced != nullptr) {
+            delete replaced;
+
+            droppedCount_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            latestCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+
+    Cell *cell;
+
+    while (true) {
+        cell = &cells_[pos & mask_];
+
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+        if (sequence == pos) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < pos) {
+            // the consumer did not free this cell yet : full
+            rejectedCount_.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->packet = std::move(packet);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+// #################################################
+//
+size_t
+SendQueue::drainTo(IoVecSink &sink) {
+    size_t count = 0;
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+
+    while (true) {
+        Cell &cell = cells_[pos & mask_];
+
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        cell.packet->encodeTo(sink);
+        cell.packet = nullptr;
+
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+
+        pos++;
+        count++;
+    }
+
+    dequeuePos_.store(pos, std::memory_order_relaxed);
+
+    if (latestCount_.load(std::memory_order_relaxed) <= 0) {
+        return count;
+    }
+
+    for (auto &&box : latest_) {
+        BaseNaio01PacketPtr *boxed = box.exchange(nullptr, std::memory_order_acq_rel);
+
+        if (boxed != nullptr) {
+            latestCount_.fetch_sub(1, std::memory_order_relaxed);
+
+            (*boxed)->encodeTo(sink);
+
+            delete boxed;
+
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// #################################################
+//
+size_t
+SendQueue::depth() const {
+    size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+    size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+
+    int64_t latestCount = latestCount_.load(std::memory_order_relaxed);
+
+    return (enqueued > dequeued ? enqueued - dequeued : 0) + static_cast<size_t>( latestCount > 0 ? latestCount : 0 );
+}
+
+// #################################################
+//
+uint64_t
+SendQueue::droppedCount() const {
+    return droppedCount_.load(std::memory_order_relaxed);
+}
+
+// #################################################
+//
+uint64_t
+SendQueue::rejectedCount() const {
+    return rejectedCount_.load(std::memory_order_relaxed);
+}
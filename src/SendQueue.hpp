@@ -0,0 +1,86 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef SEND_QUEUE_HPP
+#define SEND_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <BaseNaio01Packet.hpp>
+#include <IoVecSink.hpp>
+
+enum class SendPolicy : uint8_t
+{
+	// the packet waits for room in the queue, push( ) fails when it is full and the caller retries
+	NEVER_DROP,
+
+	// only the newest packet of its id is kept, older ones not yet sent are dropped
+	DROP_OLDEST
+};
+
+// Bounded lock-free queue of packets to send : any thread pushes, one thread drains.
+class SendQueue
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit SendQueue( size_t capacity );
+	~SendQueue( );
+
+	SendQueue( const SendQueue & ) = delete;
+	SendQueue &operator=( const SendQueue & ) = delete;
+
+	// false only for a NEVER_DROP packet pushed in a full queue
+	bool push( BaseNaio01PacketPtr packet, SendPolicy policy );
+
+	// consumer thread only : encodes every queued packet into sink, returns how many
+	size_t drainTo( IoVecSink &sink );
+
+	// packets waiting, approximate while producers are pushing
+	size_t depth( ) const;
+
+	// DROP_OLDEST packets replaced before being sent
+	uint64_t droppedCount( ) const;
+
+	// NEVER_DROP pushes refused because the queue was full
+	uint64_t rejectedCount( ) const;
+
+private:
+	struct Cell
+	{
+		std::atomic< size_t > sequence;
+		BaseNaio01PacketPtr packet;
+	};
+
+	std::unique_ptr< Cell[] > cells_;
+	size_t mask_;
+
+	// producers and consumer positions, apart so they don't share a cache line
+	std::atomic< size_t > enqueuePos_;
+	char enqueuePosPadding_[ 64 ];
+	std::atomic< size_t > dequeuePos_;
+
+	// newest DROP_OLDEST packet by packet id, swapped in and out atomically
+	std::array< std::atomic< BaseNaio01PacketPtr * >, 256 > latest_;
+	// signed : the consumer may take a packet before its producer counted it
+	std::atomic< int64_t > latestCount_;
+
+	std::atomic< uint64_t > droppedCount_;
+	std::atomic< uint64_t > rejectedCount_;
+};
+
+#endif // SEND_QUEUE_HPP
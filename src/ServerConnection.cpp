@@ -0,0 +1,344 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#include "ServerConnection.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+// #################################################
+//
+SharedSocket::SharedSocket(int socketDesc) :
+        access_{},
+        socketDesc_{socketDesc} {
+}
+
+// #################################################
+//
+ssize_t
+SharedSocket::read(void *data, size_t size) {
+    access_.lock();
+
+    ssize_t readSize = -1;
+
+    if (socketDesc_ >= 0) {
+        readSize = ::read(socketDesc_, data, size);
+    } else {
+        errno = EBADF;
+    }
+
+    access_.unlock();
+
+    return readSize;
+}
+
+// #################################################
+//
+void
+SharedSocket::invalidate() {
+    access_.lock();
+
+    socketDesc_ = -1;
+
+    access_.unlock();
+}
+
+// #################################################
+//
+ServerConnection::ServerConnection(EventLoop &eventLoop, std::string name) :
+        eventLoop_(eventLoop),
+        name_{std::move(name)},
+        host_{},
+        port_{0},
+        options_(ConnectionOptions::lowLatency()),
+        onConnected_{},
+        onEvents_{},
+        onDisconnected_{},
+        state_{State::CLOSED},
+        socketDesc_{-1},
+        sharedSocket_{nullptr},
+        connected_{false},
+        timer_{-1},
+        silenceTimeoutMs_{0},
+        lastAliveMs_{0},
+        retryDelayMs_{INITIAL_RETRY_DELAY_MS},
+        jitter_{std::random_device()()},
+        retryCount_{0} {
+    timer_ = eventLoop_.addTimer(0, [this]() { onTimer(); });
+}
+
+// #################################################
+//
+ServerConnection::~ServerConnection() {
+    close();
+
+    eventLoop_.removeTimer(timer_);
+}
+
+// #################################################
+//
+void
+ServerConnection::setCallbacks(ConnectedCallback onConnected, EventLoop::IoCallback onEvents,
+                               DisconnectedCallback onDisconnected) {
+    onConnected_ = std::move(onConnected);
+    onEvents_ = std::move(onEvents);
+    onDisconnected_ = std::move(onDisconnected);
+}
+
+// #################################################
+//
+void
+ServerConnection::setSilenceTimeout(int64_t silenceTimeoutMs) {
+    silenceTimeoutMs_ = silenceTimeoutMs;
+
+    if (state_ == State::CONNECTED and silenceTimeoutMs_ > 0) {
+        lastAliveMs_ = nowMs();
+
+        eventLoop_.armTimer(timer_, silenceTimeoutMs_);
+    }
+}
+
+// #################################################
+//
+void
+ServerConnection::open(const std::string &host, uint16_t port, const ConnectionOptions &options) {
+    host_ = host;
+    port_ = port;
+    options_ = options;
+    retryDelayMs_ = INITIAL_RETRY_DELAY_MS;
+
+    connect();
+}
+
+// #################################################
+//
+void
+ServerConnection::close() {
+    dropSocket();
+
+    state_ = State::CLOSED;
+}
+
+// #################################################
+//
+void
+ServerConnection::reconnect(const char *reason) {
+    if (state_ == State::CLOSED or state_ == State::WAITING_RETRY) {
+        return;
+    }
+
+    std::cout << name_ << " connection lost : " << reason << std::endl;
+
+    bool wasConnected = state_ == State::CONNECTED;
+
+    dropSocket();
+
+    if (wasConnected and onDisconnected_) {
+        onDisconnected_();
+    }
+
+    scheduleRetry();
+}
+
+// #################################################
+//
+void
+ServerConnection::markAlive() {
+    lastAliveMs_ = nowMs();
+}
+
+// #################################################
+//
+bool
+ServerConnection::setEvents(uint32_t events) {
+    if (state_ != State::CONNECTED) {
+        return false;
+    }
+
+    return eventLoop_.modifyFd(socketDesc_, events);
+}
+
+// #################################################
+//
+int
+ServerConnection::socketDesc() const {
+    return state_ == State::CONNECTED ? socketDesc_ : -1;
+}
+
+// #################################################
+//
+SharedSocketPtr
+ServerConnection::sharedSocket() const {
+    return state_ == State::CONNECTED ? sharedSocket_ : nullptr;
+}
+
+// #################################################
+//
+const ConnectionOptions &
+ServerConnection::options() const {
+    return options_;
+}
+
+// #################################################
+//
+bool
+ServerConnection::isConnected() const {
+    return connected_;
+}
+
+// #################################################
+//
+uint64_t
+ServerConnection::retryCount() const {
+    return retryCount_;
+}
+
+// #################################################
+//
+void
+ServerConnection::connect() {
+    socketDesc_ = startConnect(host_, port_, options_);
+
+    if (socketDesc_ < 0) {
+        std::cout << name_ << " connect error" << std::endl;
+
+        scheduleRetry();
+
+        return;
+    }
+
+    state_ = State::CONNECTING;
+
+    // writable once the handshake is over, whatever its outcome
+    eventLoop_.addFd(socketDesc_, EPOLLOUT, [this](uint32_t events) { onConnectEvents(events); });
+
+    if (options_.connectTimeoutMs > 0) {
+        eventLoop_.armTimer(timer_, options_.connectTimeoutMs);
+    }
+}
+
+// #################################################
+//
+void
+ServerConnection::onConnectEvents(uint32_t) {
+    if (not finishConnect(socketDesc_)) {
+        std::cout << name_ << " connect error" << std::endl;
+
+        dropSocket();
+        scheduleRetry();
+
+        return;
+    }
+
+    eventLoop_.removeFd(socketDesc_);
+    eventLoop_.addFd(socketDesc_, EPOLLIN, onEvents_);
+
+    state_ = State::CONNECTED;
+    sharedSocket_ = std::make_shared<SharedSocket>(socketDesc_);
+    connected_ = true;
+    retryDelayMs_ = INITIAL_RETRY_DELAY_MS;
+    lastAliveMs_ = nowMs();
+
+    if (silenceTimeoutMs_ > 0) {
+        eventLoop_.armTimer(timer_, silenceTimeoutMs_);
+    }
+
+    std::cout << "Connected " << name_ << std::endl;
+
+    if (onConnected_) {
+        onConnected_(socketDesc_);
+    }
+}
+
+// #################################################
+//
+void
+ServerConnection::onTimer() {
+    switch (state_) {
+        case State::CONNECTING:
+            std::cout << name_ << " connect timeout" << std::endl;
+
+            dropSocket();
+            scheduleRetry();
+            break;
+        case State::WAITING_RETRY:
+            connect();
+            break;
+        case State::CONNECTED:
+            // a stale connect deadline is ignored when there is no silence check
+            if (silenceTimeoutMs_ > 0) {
+                int64_t silentMs = nowMs() - lastAliveMs_;
+
+                if (silentMs >= silenceTimeoutMs_) {
+                    reconnect("nothing received");
+                } else {
+                    eventLoop_.armTimer(timer_, silenceTimeoutMs_ - silentMs);
+                }
+            }
+            break;
+        case State::CLOSED:
+            break;
+    }
+}
+
+// #################################################
+//
+void
+ServerConnection::dropSocket() {
+    if (socketDesc_ >= 0) {
+        eventLoop_.removeFd(socketDesc_);
+
+        // a read in progress on another thread is over before the descriptor can be reused
+        if (sharedSocket_ != nullptr) {
+            sharedSocket_->invalidate();
+            sharedSocket_ = nullptr;
+        }
+
+        ::close(socketDesc_);
+
+        socketDesc_ = -1;
+    }
+
+    connected_ = false;
+}
+
+// #################################################
+// the timer is the only thing left to wake the loop, an unreachable robot costs no cpu
+void
+ServerConnection::scheduleRetry() {
+    state_ = State::WAITING_RETRY;
+
+    // jittered so both channels do not hammer the robot in step
+    std::uniform_int_distribution<int64_t> jitter(0, retryDelayMs_ / 2);
+
+    eventLoop_.armTimer(timer_, retryDelayMs_ / 2 + jitter(jitter_));
+
+    retryDelayMs_ = retryDelayMs_ * 2 < MAX_RETRY_DELAY_MS ? retryDelayMs_ * 2 : MAX_RETRY_DELAY_MS;
+
+    retryCount_++;
+}
+
+// #################################################
+//
+int64_t
+ServerConnection::nowMs() {
+    return static_cast<int64_t>( duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
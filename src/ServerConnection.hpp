@@ -0,0 +1,156 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+#ifndef SERVER_CONNECTION_HPP
+#define SERVER_CONNECTION_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <sys/types.h>
+
+#include "ConnectionOptions.hpp"
+#include "EventLoop.hpp"
+
+// The connected socket as seen from the threads reading it on behalf of the loop. The loop
+// thread invalidates it before closing the descriptor, waiting for a read in progress, so a
+// descriptor handed to the next connection is never read by a late thread.
+class SharedSocket
+{
+public:
+	explicit SharedSocket( int socketDesc );
+
+	SharedSocket( const SharedSocket & ) = delete;
+	SharedSocket &operator=( const SharedSocket & ) = delete;
+
+	// any thread : -1 with errno set to EBADF once invalidated
+	ssize_t read( void *data, size_t size );
+
+	// loop thread
+	void invalidate( );
+
+private:
+	std::mutex access_;
+	int socketDesc_;
+};
+
+typedef std::shared_ptr< SharedSocket > SharedSocketPtr;
+
+// One robot server socket kept connected on an event loop : the connect never blocks the loop,
+// and a lost, refused or silent connection is retried after an exponential backoff. Everything
+// but isConnected( ) and retryCount( ) is for the loop thread only.
+class ServerConnection
+{
+public:
+	// the socket is connected and non blocking, session state is to be sent again
+	typedef std::function< void( int socketDesc ) > ConnectedCallback;
+
+	// the socket is already closed
+	typedef std::function< void( ) > DisconnectedCallback;
+
+	// first retry delay, doubled after each failure up to the max
+	static const int64_t INITIAL_RETRY_DELAY_MS = 250;
+	static const int64_t MAX_RETRY_DELAY_MS = 8000;
+
+public:
+	ServerConnection( EventLoop &eventLoop, std::string name );
+	~ServerConnection( );
+
+	ServerConnection( const ServerConnection & ) = delete;
+	ServerConnection &operator=( const ServerConnection & ) = delete;
+
+	// events are the socket epoll events once connected
+	void setCallbacks( ConnectedCallback onConnected, EventLoop::IoCallback onEvents,
+			DisconnectedCallback onDisconnected );
+
+	// reconnects when nothing was received for silenceTimeoutMs, 0 relies on errors and tcp
+	// keep-alive only. Set on a live connection, the deadline starts now.
+	void setSilenceTimeout( int64_t silenceTimeoutMs );
+
+	// connects now, then keeps the connection up until close( )
+	void open( const std::string &host, uint16_t port, const ConnectionOptions &options );
+	void close( );
+
+	// drops the socket and connects again after the backoff delay
+	void reconnect( const char *reason );
+
+	// data was received, restarts the silence deadline
+	void markAlive( );
+
+	// epoll events watched on the connected socket
+	bool setEvents( uint32_t events );
+
+	// -1 when not connected
+	int socketDesc( ) const;
+	// nullptr when not connected, a new one for each connection
+	SharedSocketPtr sharedSocket( ) const;
+	const ConnectionOptions &options( ) const;
+
+	// callable from any thread
+	bool isConnected( ) const;
+	// connections refused, timed out or lost so far
+	uint64_t retryCount( ) const;
+
+private:
+	enum class State : uint8_t
+	{
+		CLOSED,
+		CONNECTING,
+		CONNECTED,
+		WAITING_RETRY,
+	};
+
+	void connect( );
+	void onConnectEvents( uint32_t events );
+	void onTimer( );
+	void dropSocket( );
+	void scheduleRetry( );
+
+	static int64_t nowMs( );
+
+private:
+	EventLoop &eventLoop_;
+	std::string name_;
+
+	std::string host_;
+	uint16_t port_;
+	ConnectionOptions options_;
+
+	ConnectedCallback onConnected_;
+	EventLoop::IoCallback onEvents_;
+	DisconnectedCallback onDisconnected_;
+
+	State state_;
+	int socketDesc_;
+	SharedSocketPtr sharedSocket_;
+	std::atomic< bool > connected_;
+
+	// one shot : connect deadline, retry delay or silence check depending on the state
+	int timer_;
+
+	int64_t silenceTimeoutMs_;
+	int64_t lastAliveMs_;
+
+	int64_t retryDelayMs_;
+	std::minstd_rand jitter_;
+	std::atomic< uint64_t > retryCount_;
+};
+
+#endif // SERVER_CONNECTION_HPP
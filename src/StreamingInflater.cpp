@@ -0,0 +1,172 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "StreamingInflater.hpp"
+
+#include <cstring>
+
+const uint32_t StreamingInflater::PAYLOAD_HEADER_SIZE;
+
+// #################################################
+//
+StreamingInflater::StreamingInflater(size_t frameCount, size_t maxFrameSize) :
+        frameRing_{frameCount, maxFrameSize},
+        maxFrameSize_{maxFrameSize},
+        stream_{},
+        streamInitialized_{false},
+        state_{State::IDLE},
+        payloadSize_{0},
+        expectedOffset_{0},
+        payloadHeader_{},
+        imageType_{ApiStereoCameraPacket::ImageType::RAW_IMAGES},
+        output_{} {
+}
+
+// #################################################
+//
+StreamingInflater::~StreamingInflater() {
+    if (streamInitialized_) {
+        inflateEnd(&stream_);
+    }
+}
+
+// #################################################
+//
+ApiStereoCameraPacket::ImageType
+StreamingInflater::uncompressedType(ApiStereoCameraPacket::ImageType imageType) {
+    switch (imageType) {
+        case ApiStereoCameraPacket::ImageType::RAW_IMAGES_ZLIB:
+            return ApiStereoCameraPacket::ImageType::RAW_IMAGES;
+        case ApiStereoCameraPacket::ImageType::UNRECTIFIED_COLORIZED_IMAGES_ZLIB:
+            return ApiStereoCameraPacket::ImageType::UNRECTIFIED_COLORIZED_IMAGES;
+        case ApiStereoCameraPacket::ImageType::RECTIFIED_COLORIZED_IMAGES_ZLIB:
+            return ApiStereoCameraPacket::ImageType::RECTIFIED_COLORIZED_IMAGES;
+        default:
+            return imageType;
+    }
+}
+
+// #################################################
+//
+void
+StreamingInflater::onPayloadFragment(const uint8_t *fragment, uint32_t offset, uint32_t size, uint32_t payloadSize) {
+    if (offset == 0) {
+        startPayload(payloadSize);
+    } else if (offset != expectedOffset_) {
+        // a part went missing, the packet will be dropped by the codec anyway
+        state_ = State::FAILED;
+    }
+
+    expectedOffset_ = offset + size;
+
+    // the image type and data size may themselves be cut
+    while (state_ == State::HEADER and size > 0) {
+        payloadHeader_[offset] = *fragment;
+
+        offset++;
+        fragment++;
+        size--;
+
+        if (offset < PAYLOAD_HEADER_SIZE) {
+            continue;
+        }
+
+        imageType_ = static_cast<ApiStereoCameraPacket::ImageType>( payloadHeader_[0] );
+
+        if (uncompressedType(imageType_) == imageType_) {
+            // nothing to inflate, the preparer takes the data as is
+            state_ = State::IDLE;
+
+            return;
+        }
+
+        if (not streamInitialized_) {
+            streamInitialized_ = inflateInit(&stream_) == Z_OK;
+        } else if (inflateReset(&stream_) != Z_OK) {
+            streamInitialized_ = false;
+        }
+
+        output_ = frameRing_.acquire(maxFrameSize_);
+
+        if (output_ == nullptr) {
+            // every frame is still held by a packet
+            output_ = cl_copy::unique_buffer(maxFrameSize_);
+        }
+
+        if (not streamInitialized_) {
+            state_ = State::FAILED;
+
+            return;
+        }
+
+        stream_.next_out = output_->data();
+        stream_.avail_out = static_cast<uInt>( output_->size());
+
+        state_ = State::INFLATING;
+    }
+
+    if (state_ == State::INFLATING and size > 0) {
+        inflateData(fragment, size);
+    }
+}
+
+// #################################################
+//
+void
+StreamingInflater::startPayload(uint32_t payloadSize) {
+    payloadSize_ = payloadSize;
+    expectedOffset_ = 0;
+    output_ = nullptr;
+
+    state_ = (payloadSize > PAYLOAD_HEADER_SIZE) ? State::HEADER : State::IDLE;
+}
+
+// #################################################
+//
+void
+StreamingInflater::inflateData(const uint8_t *data, uint32_t size) {
+    stream_.next_in = const_cast<Bytef *>( data );
+    stream_.avail_in = size;
+
+    int result = inflate(&stream_, Z_NO_FLUSH);
+
+    if (result == Z_STREAM_END) {
+        state_ = State::DONE;
+    } else if (result != Z_OK and not (result == Z_BUF_ERROR and stream_.avail_out > 0)) {
+        // corrupted data, or more than a frame
+        state_ = State::FAILED;
+    }
+}
+
+// #################################################
+//
+bool
+StreamingInflater::takeInflated(ApiStereoCameraPacket &packet) {
+    bool inflated = state_ == State::DONE and expectedOffset_ == payloadSize_ and packet.imageType == imageType_;
+
+    if (inflated) {
+        // the packet takes the frame along, it goes back to the ring when the packet lets it go
+        output_->resize(stream_.total_out);
+        packet.dataBuffer = std::move(output_);
+        packet.imageType = uncompressedType(imageType_);
+    }
+
+    state_ = State::IDLE;
+    output_ = nullptr;
+
+    return inflated;
+}
@@ -0,0 +1,87 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef STREAMING_INFLATER_HPP
+#define STREAMING_INFLATER_HPP
+
+#include <cstdint>
+#include <zlib.h>
+
+#include "ApiCodec/ApiStereoCameraPacket.hpp"
+#include "ApiCodec/StereoFrameRing.hpp"
+
+// Inflates the zlib stereo images while their packet is still being received, fed by a
+// Naio01Codec payload stream handler. Once the packet is whole, only the last few kilobytes
+// remain to inflate instead of the whole frame. Not thread safe, meant to be used from the
+// thread decoding the image stream.
+class StreamingInflater
+{
+public:
+	// frames are inflated into a StereoFrameRing of frameCount frames and handed to the packet,
+	// a frame of its own is allocated when all of them are held by packets
+	StreamingInflater( size_t frameCount, size_t maxFrameSize );
+	~StreamingInflater( );
+
+	StreamingInflater( const StreamingInflater & ) = delete;
+	StreamingInflater &operator=( const StreamingInflater & ) = delete;
+
+	// see Naio01Codec::PayloadStreamHandler, for API_RAW_STEREO_CAMERA packets
+	void onPayloadFragment( const uint8_t *fragment, uint32_t offset, uint32_t size, uint32_t payloadSize );
+
+	// Replaces the compressed images of the packet whose payload was streamed last by the
+	// inflated ones. Leaves the packet alone when it is not compressed or was not inflated
+	// whole, the caller then falls back to uncompress( ).
+	bool takeInflated( ApiStereoCameraPacket &packet );
+
+	// uncompressed counterpart of a zlib image type, the type itself otherwise
+	static ApiStereoCameraPacket::ImageType uncompressedType( ApiStereoCameraPacket::ImageType imageType );
+
+private:
+	enum class State : uint8_t
+	{
+		IDLE,
+		HEADER,
+		INFLATING,
+		DONE,
+		FAILED
+	};
+
+	// imageType then the compressed data size, in front of the data
+	static const uint32_t PAYLOAD_HEADER_SIZE = 1 + 4;
+
+	void startPayload( uint32_t payloadSize );
+
+	void inflateData( const uint8_t *data, uint32_t size );
+
+private:
+	StereoFrameRing frameRing_;
+	size_t maxFrameSize_;
+
+	z_stream stream_;
+	bool streamInitialized_;
+
+	State state_;
+	uint32_t payloadSize_;
+	uint32_t expectedOffset_;
+
+	uint8_t payloadHeader_[ PAYLOAD_HEADER_SIZE ];
+	ApiStereoCameraPacket::ImageType imageType_;
+
+	cl_copy::BufferUPtr output_;
+};
+
+#endif // STREAMING_INFLATER_HPP
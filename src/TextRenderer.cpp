@@ -0,0 +1,207 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#include "TextRenderer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+const size_t TextRenderer::MAX_CACHED_LABELS;
+const char TextRenderer::FIRST_GLYPH;
+const char TextRenderer::LAST_GLYPH;
+
+// #################################################
+//
+TextRenderer::TextRenderer() :
+        renderer_{nullptr},
+        font_{nullptr},
+        color_{255, 255, 255, 0},
+        atlas_{nullptr},
+        glyphs_{},
+        labels_{} {
+}
+
+// #################################################
+//
+TextRenderer::~TextRenderer() {
+    // textures are freed by release(), SDL may already be gone here
+}
+
+// #################################################
+//
+bool
+TextRenderer::init(SDL_Renderer *renderer, TTF_Font *font, SDL_Color color) {
+    release();
+
+    renderer_ = renderer;
+    font_ = font;
+    color_ = color;
+
+    if (renderer_ == nullptr or font_ == nullptr) {
+        return false;
+    }
+
+    // each glyph rendered as a one character string, so it sits on the baseline as in a string
+    std::array<SDL_Surface *, LAST_GLYPH - FIRST_GLYPH + 1> surfaces{};
+
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        char text[2] = {static_cast<char>( FIRST_GLYPH + static_cast<char>( i )), '\0'};
+
+        surfaces[i] = TTF_RenderText_Solid(font_, text, color_);
+
+        Glyph &glyph = glyphs_[i];
+
+        glyph.source = {atlasWidth, 0, 0, 0};
+        glyph.advance = 0;
+
+        if (surfaces[i] != nullptr) {
+            glyph.source.w = surfaces[i]->w;
+            glyph.source.h = surfaces[i]->h;
+            glyph.advance = surfaces[i]->w;
+
+            atlasWidth += surfaces[i]->w;
+            atlasHeight = std::max(atlasHeight, surfaces[i]->h);
+        }
+
+        int minX, maxX, minY, maxY, advance;
+
+        if (TTF_GlyphMetrics(font_, static_cast<Uint16>( text[0] ), &minX, &maxX, &minY, &maxY, &advance) == 0) {
+            glyph.advance = advance;
+        }
+    }
+
+    SDL_Surface *atlasSurface = nullptr;
+
+    if (atlasWidth > 0 and atlasHeight > 0) {
+        atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    }
+
+    if (atlasSurface != nullptr) {
+        SDL_FillRect(atlasSurface, NULL, 0);
+
+        for (size_t i = 0; i < surfaces.size(); i++) {
+            if (surfaces[i] != nullptr) {
+                SDL_Rect destination = glyphs_[i].source;
+
+                // the transparent color key of solid text leaves the atlas transparent
+                SDL_BlitSurface(surfaces[i], NULL, atlasSurface, &destination);
+            }
+        }
+
+        atlas_ = SDL_CreateTextureFromSurface(renderer_, atlasSurface);
+
+        SDL_FreeSurface(atlasSurface);
+    }
+
+    for (SDL_Surface *surface : surfaces) {
+        if (surface != nullptr) {
+            SDL_FreeSurface(surface);
+        }
+    }
+
+    if (atlas_ == nullptr) {
+        std::cerr << "Failed to build the glyph atlas! Error: " << SDL_GetError() << std::endl;
+
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(atlas_, SDL_BLENDMODE_BLEND);
+
+    return true;
+}
+
+// #################################################
+//
+void
+TextRenderer::release() {
+    if (atlas_ != nullptr) {
+        SDL_DestroyTexture(atlas_);
+        atlas_ = nullptr;
+    }
+
+    for (auto &label : labels_) {
+        if (label.second.texture != nullptr) {
+            SDL_DestroyTexture(label.second.texture);
+        }
+    }
+
+    labels_.clear();
+}
+
+// #################################################
+//
+void
+TextRenderer::draw(const char *text, int x, int y) {
+    if (atlas_ == nullptr) {
+        return;
+    }
+
+    for (const char *c = text; *c != '\0'; c++) {
+        char character = (*c < FIRST_GLYPH or *c > LAST_GLYPH) ? '?' : *c;
+
+        const Glyph &glyph = glyphs_[static_cast<size_t>( character - FIRST_GLYPH )];
+
+        if (glyph.source.w > 0) {
+            SDL_Rect destination = {x, y, glyph.source.w, glyph.source.h};
+
+            SDL_RenderCopy(renderer_, atlas_, &glyph.source, &destination);
+        }
+
+        x += glyph.advance;
+    }
+}
+
+// #################################################
+//
+void
+TextRenderer::drawLabel(const char *text, int x, int y) {
+    auto found = labels_.find(text);
+
+    if (found == labels_.end()) {
+        if (font_ == nullptr or labels_.size() >= MAX_CACHED_LABELS) {
+            draw(text, x, y);
+
+            return;
+        }
+
+        Label label = {nullptr, 0, 0};
+
+        SDL_Surface *surface = TTF_RenderText_Solid(font_, text, color_);
+
+        if (surface != nullptr) {
+            label.texture = SDL_CreateTextureFromSurface(renderer_, surface);
+            label.width = surface->w;
+            label.height = surface->h;
+
+            SDL_FreeSurface(surface);
+        }
+
+        // kept even when empty, so a label that cannot be rendered is not retried every frame
+        found = labels_.emplace(text, label).first;
+    }
+
+    const Label &label = found->second;
+
+    if (label.texture != nullptr) {
+        SDL_Rect destination = {x, y, label.width, label.height};
+
+        SDL_RenderCopy(renderer_, label.texture, NULL, &destination);
+    }
+}
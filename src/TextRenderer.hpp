@@ -0,0 +1,84 @@
+//=============================================================================
+//
+//  Copyright (C)  2014  Naio Technologies
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//=============================================================================
+
+
+#ifndef TEXT_RENDERER_HPP
+#define TEXT_RENDERER_HPP
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Draws text without rasterizing it every frame. The printable ASCII glyphs of the font are
+// rendered once into an atlas texture, and a string is drawn as one copy per glyph. Labels that
+// never change get a texture of their own, drawn with a single copy. To be used from the thread
+// owning the renderer.
+class TextRenderer
+{
+public:
+	// labels beyond this are drawn from the atlas, the cache only holds the fixed texts of the ui
+	static const size_t MAX_CACHED_LABELS = 64;
+
+public:
+	TextRenderer( );
+	~TextRenderer( );
+
+	TextRenderer( const TextRenderer & ) = delete;
+	TextRenderer &operator=( const TextRenderer & ) = delete;
+
+	// false when the font is missing or the atlas cannot be built, nothing is drawn then
+	bool init( SDL_Renderer *renderer, TTF_Font *font, SDL_Color color );
+
+	// frees the textures, before the renderer goes away
+	void release( );
+
+	// text changing from frame to frame
+	void draw( const char *text, int x, int y );
+
+	// fixed text, rendered once as a whole
+	void drawLabel( const char *text, int x, int y );
+
+private:
+	static const char FIRST_GLYPH = ' ';
+	static const char LAST_GLYPH = '~';
+
+	struct Glyph
+	{
+		SDL_Rect source;
+		int advance;
+	};
+
+	struct Label
+	{
+		SDL_Texture *texture;
+		int width;
+		int height;
+	};
+
+private:
+	SDL_Renderer *renderer_;
+	TTF_Font *font_;
+	SDL_Color color_;
+
+	SDL_Texture *atlas_;
+	std::array< Glyph, LAST_GLYPH - FIRST_GLYPH + 1 > glyphs_;
+
+	std::unordered_map< std::string, Label > labels_;
+};
+
+#endif // TEXT_RENDERER_HPP
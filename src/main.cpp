@@ -1,8 +1,63 @@
 #include "Core.hpp"
+#include "Fleet.hpp"
+#include <csignal>
+#include <cstring>
 #include <sys/resource.h>
 
 #define PORT_ROBOT_MOTOR 5555
 #define DEFAULT_HOST_ADDRESS "127.0.0.1"
+#define FLEET_STATUS_RATE_S 1
+
+// ApiClient --fleet host[:port] host[:port] ... : supervises every robot from one process, without
+// display, until SIGINT or SIGTERM.
+static int runFleet( int robotCount, char** robots )
+{
+	// waited for below, no thread may take them
+	sigset_t stopSignals;
+	sigemptyset( &stopSignals );
+	sigaddset( &stopSignals, SIGINT );
+	sigaddset( &stopSignals, SIGTERM );
+	pthread_sigmask( SIG_BLOCK, &stopSignals, nullptr );
+
+	Fleet fleet;
+
+	for( int i = 0; i < robotCount; i++ )
+	{
+		std::string hostAdress = robots[ i ];
+		int hostPort = PORT_ROBOT_MOTOR;
+
+		size_t separator = hostAdress.find( ':' );
+
+		if( separator != std::string::npos )
+		{
+			hostPort = atoi( hostAdress.c_str() + separator + 1 );
+			hostAdress.resize( separator );
+		}
+
+		fleet.addRobot( hostAdress, static_cast<uint16_t>( hostPort ) );
+	}
+
+	fleet.start();
+
+	struct timespec statusRate{ FLEET_STATUS_RATE_S, 0 };
+
+	while( sigtimedwait( &stopSignals, nullptr, &statusRate ) < 0 )
+	{
+		for( size_t i = 0; i < fleet.getRobotCount(); i++ )
+		{
+			RobotSession &robot = fleet.getRobot( i );
+			RobotSession::Status status = robot.getStatus();
+
+			std::cout << robot.getName() << ( status.connected ? " connected" : " disconnected" )
+					<< " packets " << status.packetsReceived << " images " << status.imagesReceived
+					<< " retries " << status.connectionRetries << std::endl;
+		}
+	}
+
+	fleet.stop();
+
+	return 0;
+}
 
 
 int main( int argc, char** argv )
@@ -25,6 +80,11 @@ int main( int argc, char** argv )
 //		}
 //	}
 
+	if( argc > 1 and std::strcmp( argv[ 1 ], "--fleet" ) == 0 )
+	{
+		return runFleet( argc - 2, argv + 2 );
+	}
+
 	std::string hostAdress = DEFAULT_HOST_ADDRESS;
 
 	int hostPort = PORT_ROBOT_MOTOR;